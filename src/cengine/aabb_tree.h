@@ -0,0 +1,502 @@
+#ifndef CENGINE_AABB_TREE_H
+#define CENGINE_AABB_TREE_H
+
+#include <algorithm>
+#include <unordered_map>
+#include "broadphase.h"
+
+namespace cen {
+
+inline AABB AABBUnion(const AABB& a, const AABB& b) {
+    return {
+        { std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y) },
+        { std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y) }
+    };
+}
+
+inline bool AABBContains(const AABB& outer, const AABB& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+        outer.max.x >= inner.max.x && outer.max.y >= inner.max.y;
+}
+
+inline float AABBPerimeter(const AABB& a) {
+    return 2.0f * ((a.max.x - a.min.x) + (a.max.y - a.min.y));
+}
+
+// # Dynamic AABB tree
+// Leaves hold collider bounds fattened by margin. A leaf is reinserted only
+// when its collider leaves the fat bounds, and only reinserted leaves query
+// the tree for new pairs. Pairs of fat bounds are kept between ticks.
+
+class AABBTree: public Broadphase {
+    private:
+        static constexpr int32_t Null = -1;
+        static constexpr int32_t QueryStackSize = 256;
+
+        struct TreeNode {
+            AABB bounds;
+            int32_t parent;
+            int32_t left;
+            int32_t right;
+            // # -1 when free, 0 for leaves
+            int32_t height;
+
+            // # Leaves only
+            node_id_t id;
+            uint32_t proxy;
+            uint64_t stamp;
+
+            bool IsLeaf() const {
+                return this->left == Null;
+            }
+        };
+
+        std::vector<TreeNode> nodes;
+        int32_t root = Null;
+        int32_t freeList = Null;
+        uint64_t stamp = 0;
+
+        std::unordered_map<node_id_t, int32_t> leafById;
+
+        // # Leaf pairs with overlapping fat bounds, sorted
+        std::vector<uint64_t> pairKeys;
+
+        // # Reused between ticks to avoid reallocation
+        std::vector<uint64_t> newPairKeys;
+        std::vector<uint64_t> mergedPairKeys;
+        std::vector<int32_t> movedLeaves;
+        std::vector<int32_t> removedLeaves;
+        std::vector<int32_t> stack;
+
+        static uint64_t PairKey(int32_t a, int32_t b) {
+            if (a > b) {
+                std::swap(a, b);
+            }
+
+            return (static_cast<uint64_t>(a) << 32) | static_cast<uint32_t>(b);
+        }
+
+        AABB Fatten(const AABB& bounds) const {
+            return {
+                { bounds.min.x - this->margin, bounds.min.y - this->margin },
+                { bounds.max.x + this->margin, bounds.max.y + this->margin }
+            };
+        }
+
+        int32_t AllocateNode() {
+            int32_t index;
+
+            if (this->freeList == Null) {
+                index = static_cast<int32_t>(this->nodes.size());
+                this->nodes.push_back(TreeNode{});
+            } else {
+                index = this->freeList;
+                this->freeList = this->nodes[index].parent;
+            }
+
+            auto& node = this->nodes[index];
+            node.parent = Null;
+            node.left = Null;
+            node.right = Null;
+            node.height = 0;
+
+            return index;
+        }
+
+        void FreeNode(int32_t index) {
+            this->nodes[index].parent = this->freeList;
+            this->nodes[index].height = -1;
+            this->freeList = index;
+        }
+
+        void ReplaceChild(int32_t parent, int32_t oldChild, int32_t newChild) {
+            if (parent == Null) {
+                this->root = newChild;
+                return;
+            }
+
+            if (this->nodes[parent].left == oldChild) {
+                this->nodes[parent].left = newChild;
+            } else {
+                this->nodes[parent].right = newChild;
+            }
+        }
+
+        void Refit(int32_t index) {
+            auto& node = this->nodes[index];
+            const auto& left = this->nodes[node.left];
+            const auto& right = this->nodes[node.right];
+
+            node.height = 1 + std::max(left.height, right.height);
+            node.bounds = AABBUnion(left.bounds, right.bounds);
+        }
+
+        // # Rotates the higher child up if subtree is unbalanced, returns new subtree root
+        int32_t Balance(int32_t iA) {
+            auto& a = this->nodes[iA];
+
+            if (a.IsLeaf() || a.height < 2) {
+                return iA;
+            }
+
+            auto iB = a.left;
+            auto iC = a.right;
+            auto& b = this->nodes[iB];
+            auto& c = this->nodes[iC];
+
+            auto balance = c.height - b.height;
+
+            // ## Rotate C up
+            if (balance > 1) {
+                auto iF = c.left;
+                auto iG = c.right;
+                auto& f = this->nodes[iF];
+                auto& g = this->nodes[iG];
+
+                c.left = iA;
+                c.parent = a.parent;
+                a.parent = iC;
+                this->ReplaceChild(c.parent, iA, iC);
+
+                if (f.height > g.height) {
+                    c.right = iF;
+                    a.right = iG;
+                    g.parent = iA;
+                } else {
+                    c.right = iG;
+                    a.right = iF;
+                    f.parent = iA;
+                }
+
+                this->Refit(iA);
+                this->Refit(iC);
+
+                return iC;
+            }
+
+            // ## Rotate B up
+            if (balance < -1) {
+                auto iD = b.left;
+                auto iE = b.right;
+                auto& d = this->nodes[iD];
+                auto& e = this->nodes[iE];
+
+                b.left = iA;
+                b.parent = a.parent;
+                a.parent = iB;
+                this->ReplaceChild(b.parent, iA, iB);
+
+                if (d.height > e.height) {
+                    b.right = iD;
+                    a.left = iE;
+                    e.parent = iA;
+                } else {
+                    b.right = iE;
+                    a.left = iD;
+                    d.parent = iA;
+                }
+
+                this->Refit(iA);
+                this->Refit(iB);
+
+                return iB;
+            }
+
+            return iA;
+        }
+
+        void RefitAncestors(int32_t index) {
+            while (index != Null) {
+                index = this->Balance(index);
+                this->Refit(index);
+                index = this->nodes[index].parent;
+            }
+        }
+
+        void InsertLeaf(int32_t leaf) {
+            if (this->root == Null) {
+                this->root = leaf;
+                this->nodes[leaf].parent = Null;
+                return;
+            }
+
+            // # Find best sibling by perimeter heuristic
+            auto leafBounds = this->nodes[leaf].bounds;
+            auto index = this->root;
+
+            while (!this->nodes[index].IsLeaf()) {
+                const auto& node = this->nodes[index];
+
+                auto perimeter = AABBPerimeter(node.bounds);
+                auto combinedPerimeter = AABBPerimeter(AABBUnion(node.bounds, leafBounds));
+
+                auto cost = 2.0f * combinedPerimeter;
+                auto inheritanceCost = 2.0f * (combinedPerimeter - perimeter);
+
+                auto childCost = [&](int32_t child) {
+                    const auto& childNode = this->nodes[child];
+                    auto unionPerimeter = AABBPerimeter(AABBUnion(childNode.bounds, leafBounds));
+
+                    if (childNode.IsLeaf()) {
+                        return unionPerimeter + inheritanceCost;
+                    }
+
+                    return unionPerimeter - AABBPerimeter(childNode.bounds) + inheritanceCost;
+                };
+
+                auto costLeft = childCost(node.left);
+                auto costRight = childCost(node.right);
+
+                if (cost < costLeft && cost < costRight) {
+                    break;
+                }
+
+                index = costLeft < costRight ? node.left : node.right;
+            }
+
+            // # Create new parent for sibling and leaf
+            auto sibling = index;
+            auto oldParent = this->nodes[sibling].parent;
+            auto newParent = this->AllocateNode();
+
+            this->nodes[newParent].parent = oldParent;
+            this->nodes[newParent].left = sibling;
+            this->nodes[newParent].right = leaf;
+            this->ReplaceChild(oldParent, sibling, newParent);
+
+            this->nodes[sibling].parent = newParent;
+            this->nodes[leaf].parent = newParent;
+
+            this->RefitAncestors(newParent);
+        }
+
+        void RemoveLeaf(int32_t leaf) {
+            if (leaf == this->root) {
+                this->root = Null;
+                return;
+            }
+
+            auto parent = this->nodes[leaf].parent;
+            auto grandParent = this->nodes[parent].parent;
+            auto sibling = this->nodes[parent].left == leaf
+                ? this->nodes[parent].right
+                : this->nodes[parent].left;
+
+            this->ReplaceChild(grandParent, parent, sibling);
+            this->nodes[sibling].parent = grandParent;
+            this->FreeNode(parent);
+
+            this->RefitAncestors(grandParent);
+        }
+
+        // # Appends pairs of leaf with every other leaf whose bounds overlap its bounds
+        void QueryLeaf(int32_t leaf) {
+            if (this->root == Null) {
+                return;
+            }
+
+            const auto bounds = this->nodes[leaf].bounds;
+
+            this->stack.clear();
+            this->stack.push_back(this->root);
+
+            while (!this->stack.empty()) {
+                auto index = this->stack.back();
+                this->stack.pop_back();
+
+                const auto& node = this->nodes[index];
+
+                if (!AABBOverlap(node.bounds, bounds)) {
+                    continue;
+                }
+
+                if (node.IsLeaf()) {
+                    if (index != leaf) {
+                        this->newPairKeys.push_back(PairKey(leaf, index));
+                    }
+                    continue;
+                }
+
+                this->stack.push_back(node.left);
+                this->stack.push_back(node.right);
+            }
+        }
+
+        bool IsLiveLeaf(int32_t index) const {
+            return this->nodes[index].height == 0;
+        }
+
+    public:
+        float margin;
+
+        AABBTree(float margin = 4.0f) {
+            this->margin = margin;
+        }
+
+        void FindPairs(
+            const std::vector<BroadphaseProxy>& proxies,
+            std::vector<BroadphasePair>& pairs
+        ) override {
+            this->stamp++;
+            this->movedLeaves.clear();
+            this->removedLeaves.clear();
+            this->newPairKeys.clear();
+
+            // # Sync leaves with proxies
+            for (uint32_t i = 0; i < proxies.size(); i++) {
+                const auto& proxy = proxies[i];
+                auto found = this->leafById.find(proxy.id);
+
+                if (found == this->leafById.end()) {
+                    auto leaf = this->AllocateNode();
+                    auto& node = this->nodes[leaf];
+                    node.bounds = this->Fatten(proxy.bounds);
+                    node.id = proxy.id;
+                    node.proxy = i;
+                    node.stamp = this->stamp;
+
+                    this->leafById[proxy.id] = leaf;
+                    this->InsertLeaf(leaf);
+                    this->movedLeaves.push_back(leaf);
+                    continue;
+                }
+
+                auto leaf = found->second;
+                auto& node = this->nodes[leaf];
+                node.proxy = i;
+                node.stamp = this->stamp;
+
+                // ## Refit only when collider left its fat bounds
+                if (!AABBContains(node.bounds, proxy.bounds)) {
+                    this->RemoveLeaf(leaf);
+                    this->nodes[leaf].bounds = this->Fatten(proxy.bounds);
+                    this->InsertLeaf(leaf);
+                    this->movedLeaves.push_back(leaf);
+                }
+            }
+
+            // # Remove leaves of colliders that are gone
+            for (auto it = this->leafById.begin(); it != this->leafById.end();) {
+                if (this->nodes[it->second].stamp != this->stamp) {
+                    this->removedLeaves.push_back(it->second);
+                    it = this->leafById.erase(it);
+                } else {
+                    it++;
+                }
+            }
+
+            for (auto leaf: this->removedLeaves) {
+                this->RemoveLeaf(leaf);
+                this->FreeNode(leaf);
+            }
+
+            // # Drop pairs that stopped overlapping or lost a leaf
+            // (a freed leaf can't be reused before this point)
+            this->pairKeys.erase(
+                std::remove_if(
+                    this->pairKeys.begin(),
+                    this->pairKeys.end(),
+                    [this](uint64_t key) {
+                        auto a = static_cast<int32_t>(key >> 32);
+                        auto b = static_cast<int32_t>(key & 0xFFFFFFFF);
+
+                        if (!this->IsLiveLeaf(a) || !this->IsLiveLeaf(b)) {
+                            return true;
+                        }
+
+                        return !AABBOverlap(this->nodes[a].bounds, this->nodes[b].bounds);
+                    }
+                ),
+                this->pairKeys.end()
+            );
+
+            // # Only moved leaves can have new pairs
+            for (auto leaf: this->movedLeaves) {
+                this->QueryLeaf(leaf);
+            }
+
+            std::sort(this->newPairKeys.begin(), this->newPairKeys.end());
+            this->newPairKeys.erase(
+                std::unique(this->newPairKeys.begin(), this->newPairKeys.end()),
+                this->newPairKeys.end()
+            );
+
+            this->mergedPairKeys.clear();
+            std::set_union(
+                this->pairKeys.begin(),
+                this->pairKeys.end(),
+                this->newPairKeys.begin(),
+                this->newPairKeys.end(),
+                std::back_inserter(this->mergedPairKeys)
+            );
+            std::swap(this->pairKeys, this->mergedPairKeys);
+
+            // # Report pairs whose actual bounds overlap
+            for (auto key: this->pairKeys) {
+                auto a = this->nodes[static_cast<int32_t>(key >> 32)].proxy;
+                auto b = this->nodes[static_cast<int32_t>(key & 0xFFFFFFFF)].proxy;
+
+                if (!ProxiesLayersMatch(proxies[a], proxies[b]) || !AABBOverlap(proxies[a].bounds, proxies[b].bounds)) {
+                    continue;
+                }
+
+                pairs.push_back({ std::min(a, b), std::max(a, b) });
+            }
+        }
+
+        // # Leaves whose fat bounds overlap bounds
+        void Query(
+            const AABB& bounds,
+            std::vector<uint32_t>& found
+        ) const override {
+            if (this->root == Null) {
+                return;
+            }
+
+            // ## Local stack, so queries don't touch tree state (tree is balanced,
+            // its height stays far below this, degenerate trees spill to heap)
+            int32_t stack[QueryStackSize];
+            int32_t top = 0;
+            std::vector<int32_t> overflow;
+
+            auto push = [&](int32_t index) {
+                if (top < QueryStackSize) {
+                    stack[top++] = index;
+                    return;
+                }
+
+                overflow.push_back(index);
+            };
+
+            push(this->root);
+
+            while (top > 0 || !overflow.empty()) {
+                int32_t index;
+
+                if (!overflow.empty()) {
+                    index = overflow.back();
+                    overflow.pop_back();
+                } else {
+                    index = stack[--top];
+                }
+
+                const auto& node = this->nodes[index];
+
+                if (!AABBOverlap(node.bounds, bounds)) {
+                    continue;
+                }
+
+                if (node.IsLeaf()) {
+                    found.push_back(node.proxy);
+                    continue;
+                }
+
+                push(node.left);
+                push(node.right);
+            }
+        }
+};
+
+} // namespace cen
+
+#endif // CENGINE_AABB_TREE_H
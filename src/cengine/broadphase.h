@@ -0,0 +1,81 @@
+#ifndef CENGINE_BROADPHASE_H
+#define CENGINE_BROADPHASE_H
+
+#include <vector>
+#include "core.h"
+
+namespace cen {
+
+// # AABB
+
+struct AABB {
+    Vector2 min;
+    Vector2 max;
+};
+
+inline bool AABBOverlap(const AABB& a, const AABB& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+        a.min.y <= b.max.y && a.max.y >= b.min.y;
+}
+
+// # Collision layers
+// Collider is on layers set in layer bits and sees layers set in mask bits,
+// pair is tested only when either collider sees the other one
+
+constexpr uint32_t CollisionLayerDefault = 1;
+constexpr uint32_t CollisionMaskAll = 0xFFFFFFFF;
+
+inline bool CollisionLayersMatch(uint32_t layerA, uint32_t maskA, uint32_t layerB, uint32_t maskB) {
+    return (layerA & maskB) != 0 || (layerB & maskA) != 0;
+}
+
+// # Broadphase
+
+struct BroadphaseProxy {
+    // # Collider node id (stable between ticks)
+    node_id_t id;
+    AABB bounds;
+    uint32_t layer = CollisionLayerDefault;
+    uint32_t mask = CollisionMaskAll;
+};
+
+inline bool ProxiesLayersMatch(const BroadphaseProxy& a, const BroadphaseProxy& b) {
+    return CollisionLayersMatch(a.layer, a.mask, b.layer, b.mask);
+}
+
+struct BroadphasePair {
+    // # Indexes in proxies array (a < b)
+    uint32_t a;
+    uint32_t b;
+
+    bool operator<(const BroadphasePair& other) const {
+        return this->a < other.a || (this->a == other.a && this->b < other.b);
+    }
+
+    bool operator==(const BroadphasePair& other) const {
+        return this->a == other.a && this->b == other.b;
+    }
+};
+
+class Broadphase {
+    public:
+        virtual ~Broadphase() {}
+
+        // # Appends every pair of proxies whose bounds overlap and layers match
+        // (may contain false positives, must not contain duplicates)
+        virtual void FindPairs(
+            const std::vector<BroadphaseProxy>& proxies,
+            std::vector<BroadphasePair>& pairs
+        ) = 0;
+
+        // # Appends indexes of proxies (of last FindPairs) whose bounds may overlap bounds
+        // (may contain false positives and duplicates, doesn't change broadphase)
+        virtual void Query(
+            const AABB& bounds,
+            std::vector<uint32_t>& found
+        ) const = 0;
+};
+
+} // namespace cen
+
+#endif // CENGINE_BROADPHASE_H
@@ -5,13 +5,25 @@
 #include "scene.h"
 #include "event.h"
 #include "node.h"
+#include "node_id_generator.h"
+#include "node_pool.h"
 #include "timer.h"
+#include "transform_2d.h"
 #include "node_2d.h"
 #include "node_storage.h"
 #include "node_node_storage.h"
 #include "gui.h"
 #include "view.h"
 #include "rendering.h"
+#include "broadphase.h"
+#include "grid_cells.h"
+#include "spatial_hash_grid.h"
+#include "aabb_tree.h"
+#include "sweep_and_prune.h"
+#include "static_grid.h"
+#include "narrowphase_simd.h"
+#include "worker_pool.h"
+#include "collision_pair_table.h"
 #include "collision.h"
 #include "character_body_node_2d.h"
 #include "debug.h"
@@ -2,6 +2,6 @@
 
 namespace cen {
 
-const uint64_t CharacterBody2D::_tid = cen::TypeIdGenerator::getInstance().getNextId();
+const uint64_t CharacterBody2D::_tid = cen::TypeIdGenerator::getInstance().getNextId(&CollisionObject2D::_tid);
 
 }
\ No newline at end of file
@@ -38,31 +38,25 @@ class CharacterBody2D: public CollisionObject2D {
         ) : CollisionObject2D(position, zOrder, id, parent) {
             this->size = size;
             this->velocity = velocity;
+            this->motionMode = motionMode;
+            this->up = up;
+            this->skinWidth = skinWidth;
         }
 
         void ApplyVelocityToPosition() {
-            this->position.x += this->velocity.x;
-            this->position.y += this->velocity.y;
+            this->Translate(this->velocity);
         }
 
-        void MoveAndSlide() {
-            if (this->velocity.x == 0 && this->velocity.y == 0) {
-                return;
-            }
-
-            auto newPosition = Vector2Add(
-                Vector2Add(
-                    this->GlobalPosition(),
-                    (Vector2){
-                        this->skinWidth,
-                        this->skinWidth
-                    }
-                ),
-                this->velocity
-            );
+        // # First contact of own solid colliders moving by motion (swept, so fast
+        // bodies don't tunnel through thin ones), found by CollisionEngine::ShapeCast
+        SweepHit FirstContact(
+            Vector2 motion,
+            Collision& collision
+        ) {
+            SweepHit first = SweepMiss;
 
             for (const auto& node: this->children) {
-                auto collider = node->GetFirstByType<Collider>();
+                auto collider = node->As<Collider>();
 
                 if (collider == nullptr) {
                     continue;
@@ -72,169 +66,112 @@ class CharacterBody2D: public CollisionObject2D {
                     continue;
                 }
 
-                for (const auto& otherNode: this->scene->nodeStorage->rootNodes) {
-                    if (this == otherNode.get()) {
-                        continue;
-                    }
-
-                    auto otherCollisionObject = otherNode->GetFirstByType<CollisionObject2D>();
-
-                    if (otherCollisionObject == nullptr) {
-                        continue;
-                    }
-
-                    for (const auto& otherN: otherCollisionObject->children) {
-                        auto otherCollider = dynamic_cast<Collider*>(otherN.get());
-
-                        if (otherCollider == nullptr) {
-                            continue;
-                        }
-
-                        if (otherCollider->type == ColliderType::Sensor) {
-                            continue;
-                        }
-
-                        auto collision = CollisionHit{0, Vector2{}};
-
-                        switch (collider->shape.type) {
-                            case Shape::Type::RECTANGLE:
-                                switch (otherCollider->shape.type) {
-                                    case Shape::Type::RECTANGLE:
-                                        break;
-                                    case Shape::Type::CIRCLE:
-                                        collision = CircleRectangleCollision(
-                                            otherCollider->GlobalPosition(),
-                                            otherCollider->shape.circle.radius,
-                                            newPosition,
-                                            collider->shape.rect.size
-                                        );
-                                        break;
-                                }
-                                break;
-                            case Shape::Type::CIRCLE:
-                                switch (otherCollider->shape.type) {
-                                    case Shape::Type::RECTANGLE:
-                                        collision = CircleRectangleCollision(
-                                            newPosition,
-                                            collider->shape.circle.radius,
-                                            otherCollider->GlobalPosition(),
-                                            otherCollider->shape.rect.size
-                                        );
-                                        break;
-                                    case Shape::Type::CIRCLE:
-                                        break;
-                                }
-                                break;
-                        }
-
-                        if (collision.penetration > 0) {
-                            auto d = Vector2DotProduct(this->velocity, collision.normal);
-                            if (d < 0) {
-                                this->velocity.x += collision.normal.x * collision.penetration;
-                                this->velocity.y += collision.normal.y * collision.penetration;
-                            } else {
-                                this->velocity.x -= collision.normal.x * collision.penetration;
-                                this->velocity.y -= collision.normal.y * collision.penetration;
-                            }
-                        }
-                    }
+                CastHit hit;
+
+                // ## Scaled by cached global transform
+                auto count = this->scene->collisionEngine->ShapeCast(
+                    this->scene->nodeStorage.get(),
+                    collider->GlobalShape(),
+                    collider->GlobalPosition(),
+                    motion,
+                    QueryFilter{ collider->layer, collider->mask, this },
+                    &hit,
+                    1
+                );
+
+                if (count > 0 && hit.hit.time < first.time) {
+                    first = hit.hit;
+                    collision.selfCollider = collider;
+                    collision.other = hit.collisionObject;
+                    collision.otherCollider = hit.collider;
                 }
             }
 
-            this->ApplyVelocityToPosition();
+            if (first.Hit()) {
+                // ## Motion left after contact going into other body
+                auto rest = Vector2Scale(motion, 1 - first.time);
+                collision.hit = CollisionHit{
+                    std::max(-Vector2DotProduct(rest, first.normal), 0.0f),
+                    first.normal
+                };
+            }
+
+            return first;
         }
 
-        std::vector<Collision> MoveAndCollide(
-            
+        // # Moves to first contact, keeping skinWidth from it
+        void MoveToContact(
+            Vector2 motion,
+            SweepHit hit
         ) {
-            std::vector<Collision> collisions;
+            auto length = Vector2Length(motion);
+            auto time = hit.time;
 
-            auto newPosition = Vector2Add(
-                Vector2Add(
-                    this->GlobalPosition(),
-                    (Vector2){
-                        this->skinWidth,
-                        this->skinWidth
-                    }
-                ),
-                this->velocity
-            );
+            if (length > 0) {
+                time = std::max(time - this->skinWidth / length, 0.0f);
+            }
 
-            for (const auto& node: this->children) {
-                auto collider = dynamic_cast<Collider*>(node.get());
+            this->Translate(Vector2Scale(motion, time));
+        }
 
-                if (collider == nullptr) {
-                    continue;
+        // # Moves by velocity sliding along bodies hit, velocity loses part going
+        // into them
+        void MoveAndSlide(
+            int maxSlides = 4
+        ) {
+            if (this->velocity.x == 0 && this->velocity.y == 0) {
+                return;
+            }
+
+            auto motion = this->velocity;
+
+            for (int slide = 0; slide < maxSlides; slide++) {
+                Collision collision = {};
+                auto hit = this->FirstContact(motion, collision);
+
+                if (!hit.Hit()) {
+                    this->Translate(motion);
+                    return;
                 }
 
-                if (collider->type == ColliderType::Sensor) {
-                    continue;
+                this->MoveToContact(motion, hit);
+
+                // ## Rest of motion and velocity along contact
+                motion = Vector2Scale(motion, 1 - hit.time);
+                motion = Vector2Subtract(
+                    motion,
+                    Vector2Scale(hit.normal, Vector2DotProduct(motion, hit.normal))
+                );
+
+                auto into = Vector2DotProduct(this->velocity, hit.normal);
+                if (into < 0) {
+                    this->velocity = Vector2Subtract(
+                        this->velocity,
+                        Vector2Scale(hit.normal, into)
+                    );
                 }
 
-                for (const auto& otherNode: this->scene->nodeStorage->rootNodes) {
-                    if (this == otherNode.get()) {
-                        continue;
-                    }
-
-                    auto otherCollisionObject = otherNode->GetFirstByType<CollisionObject2D>();
-                    if (otherCollisionObject == nullptr) {
-                        continue;
-                    }
-
-                    for (const auto& otherN: otherNode->children) {
-                        auto otherCollider = dynamic_cast<Collider*>(otherN.get());
-
-                        if (otherCollider == nullptr) {
-                            continue;
-                        }
-
-                        if (otherCollider->type == ColliderType::Sensor) {
-                            continue;
-                        }
-
-                        auto collision = CollisionHit{0, Vector2{}};
-
-                        switch (collider->shape.type) {
-                            case Shape::Type::RECTANGLE:
-                                switch (otherCollider->shape.type) {
-                                    case Shape::Type::RECTANGLE:
-                                        break;
-                                    case Shape::Type::CIRCLE:
-                                        collision = CircleRectangleCollision(
-                                            otherCollider->GlobalPosition(),
-                                            otherCollider->shape.circle.radius,
-                                            newPosition,
-                                            collider->shape.rect.size
-                                        );
-                                        break;
-                                }
-                                break;
-                            case Shape::Type::CIRCLE:
-                                switch (otherCollider->shape.type) {
-                                    case Shape::Type::RECTANGLE:
-                                        collision = CircleRectangleCollision(
-                                            newPosition,
-                                            collider->shape.circle.radius,
-                                            otherCollider->GlobalPosition(),
-                                            otherCollider->shape.rect.size
-                                        );
-                                        break;
-                                    case Shape::Type::CIRCLE:
-                                        break;
-                                }
-                                break;
-                        }
-
-                        if (collision.penetration > 0) {
-                            collisions.push_back(Collision{
-                                collision,
-                                collider,
-                                otherCollisionObject
-                            });
-                        }
-                    }
+                if (motion.x == 0 && motion.y == 0) {
+                    return;
                 }
             }
+        }
+
+        // # Moves by velocity stopping at first contact, returns it (empty when
+        // nothing was hit)
+        std::vector<Collision> MoveAndCollide() {
+            std::vector<Collision> collisions;
+
+            Collision collision = {};
+            auto hit = this->FirstContact(this->velocity, collision);
+
+            if (!hit.Hit()) {
+                this->ApplyVelocityToPosition();
+                return collisions;
+            }
+
+            this->MoveToContact(this->velocity, hit);
+            collisions.push_back(collision);
 
             return collisions;
         }
@@ -2,8 +2,10 @@
 
 namespace cen {
 
-const cen::type_id_t Collider::_tid = cen::TypeIdGenerator::getInstance().getNextId();
+const cen::type_id_t Collider::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node2D::_tid);
 
-const cen::type_id_t CollisionObject2D::_tid = cen::TypeIdGenerator::getInstance().getNextId();
+const cen::type_id_t CollisionObject2D::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node2D::_tid);
+
+const cen::type_id_t TileMapCollision2D::_tid = cen::TypeIdGenerator::getInstance().getNextId(&CollisionObject2D::_tid);
 
 }
\ No newline at end of file
@@ -2,8 +2,21 @@
 #define CENGINE_COLLISION_H
 
 #include <memory>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <span>
 #include "node_2d.h"
 #include "node_storage.h"
+#include "broadphase.h"
+#include "spatial_hash_grid.h"
+#include "aabb_tree.h"
+#include "sweep_and_prune.h"
+#include "static_grid.h"
+#include "collision_pair_table.h"
+#include "narrowphase_simd.h"
+#include "worker_pool.h"
+#include "tilemap.h"
 
 namespace cen {
 
@@ -99,6 +112,214 @@ static CollisionHit CircleCircleCollision(
     };
 }
 
+// # Continuous collision
+// Swept tests of shape moving by motion against still shape (use relative motion
+// when both move). Time is fraction of motion before first contact, shapes already
+// overlapping and moving deeper hit at time 0, moving apart they don't hit.
+struct SweepHit {
+    // # 1 when nothing is hit
+    float time;
+    Vector2 normal;
+
+    bool Hit() const {
+        return this->time < 1;
+    }
+};
+
+constexpr SweepHit SweepMiss { 1, Vector2{} };
+
+// # Ray origin + motion * t against circle, origin outside of circle
+static bool RayCircleTime(
+    Vector2 origin,
+    Vector2 motion,
+    Vector2 center,
+    float radius,
+    float& time
+) {
+    Vector2 offset = Vector2Subtract(origin, center);
+    float a = Vector2DotProduct(motion, motion);
+    float b = Vector2DotProduct(offset, motion);
+    float c = Vector2DotProduct(offset, offset) - radius * radius;
+
+    if (a == 0 || b >= 0) {
+        return false;
+    }
+
+    float discriminant = b * b - a * c;
+    if (discriminant < 0) {
+        return false;
+    }
+
+    time = (-b - std::sqrt(discriminant)) / a;
+    return time < 1;
+}
+
+// # Ray origin + motion * t against box, time and normal of entry
+// (time is 0 when origin is inside, normal is still of the nearest entry side)
+static bool RayBoxTime(
+    Vector2 origin,
+    Vector2 motion,
+    Vector2 min,
+    Vector2 max,
+    float& time,
+    Vector2& normal
+) {
+    if (motion.x == 0 && motion.y == 0) {
+        return false;
+    }
+
+    float enter = -std::numeric_limits<float>::infinity();
+    float exit = 1;
+    normal = Vector2{};
+
+    const float originAxes[2] = { origin.x, origin.y };
+    const float motionAxes[2] = { motion.x, motion.y };
+    const float minAxes[2] = { min.x, min.y };
+    const float maxAxes[2] = { max.x, max.y };
+
+    for (int axis = 0; axis < 2; axis++) {
+        // ## Sliding along side (touching it) is not a hit
+        if (motionAxes[axis] == 0) {
+            if (originAxes[axis] <= minAxes[axis] || originAxes[axis] >= maxAxes[axis]) {
+                return false;
+            }
+            continue;
+        }
+
+        float near = (minAxes[axis] - originAxes[axis]) / motionAxes[axis];
+        float far = (maxAxes[axis] - originAxes[axis]) / motionAxes[axis];
+        float side = -1;
+
+        if (near > far) {
+            std::swap(near, far);
+            side = 1;
+        }
+
+        if (near > enter) {
+            enter = near;
+            normal = axis == 0 ? Vector2{ side, 0 } : Vector2{ 0, side };
+        }
+
+        exit = std::min(exit, far);
+    }
+
+    if (enter > exit || exit <= 0) {
+        return false;
+    }
+
+    time = std::max(enter, 0.0f);
+    return true;
+}
+
+static SweepHit CircleCircleSweep(
+    Vector2 positionA,
+    float radiusA,
+    Vector2 motion,
+    Vector2 positionB,
+    float radiusB
+) {
+    auto overlap = CircleCircleCollision(positionA, radiusA, positionB, radiusB);
+    if (overlap.penetration > 0) {
+        return Vector2DotProduct(motion, overlap.normal) < 0
+            ? SweepHit{ 0, overlap.normal }
+            : SweepMiss;
+    }
+
+    float time;
+    if (!RayCircleTime(positionA, motion, positionB, radiusA + radiusB, time)) {
+        return SweepMiss;
+    }
+
+    auto contact = Vector2Add(positionA, Vector2Scale(motion, time));
+    return { time, Vector2Normalize(Vector2Subtract(contact, positionB)) };
+}
+
+// # Circle against rectangle grown by radius (rounded corners)
+static SweepHit CircleRectangleSweep(
+    Vector2 circlePosition,
+    float circleRadius,
+    Vector2 motion,
+    Vector2 rectPosition,
+    cen::Size rectSize
+) {
+    auto overlap = CircleRectangleCollision(circlePosition, circleRadius, rectPosition, rectSize);
+    if (overlap.penetration > 0) {
+        return Vector2DotProduct(motion, overlap.normal) < 0
+            ? SweepHit{ 0, overlap.normal }
+            : SweepMiss;
+    }
+
+    Vector2 rectMin = { rectPosition.x - rectSize.width/2, rectPosition.y - rectSize.height/2 };
+    Vector2 rectMax = { rectPosition.x + rectSize.width/2, rectPosition.y + rectSize.height/2 };
+
+    float time;
+    Vector2 normal;
+    if (!RayBoxTime(
+        circlePosition,
+        motion,
+        Vector2{ rectMin.x - circleRadius, rectMin.y - circleRadius },
+        Vector2{ rectMax.x + circleRadius, rectMax.y + circleRadius },
+        time,
+        normal
+    ) || time >= 1) {
+        return SweepMiss;
+    }
+
+    auto contact = Vector2Add(circlePosition, Vector2Scale(motion, time));
+    bool insideX = contact.x >= rectMin.x && contact.x <= rectMax.x;
+    bool insideY = contact.y >= rectMin.y && contact.y <= rectMax.y;
+
+    // ## Face of rectangle
+    if (insideX || insideY) {
+        return { time, normal };
+    }
+
+    // ## Rounded corner
+    Vector2 corner = {
+        contact.x < rectMin.x ? rectMin.x : rectMax.x,
+        contact.y < rectMin.y ? rectMin.y : rectMax.y
+    };
+
+    if (!RayCircleTime(circlePosition, motion, corner, circleRadius, time)) {
+        return SweepMiss;
+    }
+
+    contact = Vector2Add(circlePosition, Vector2Scale(motion, time));
+    return { time, Vector2Normalize(Vector2Subtract(contact, corner)) };
+}
+
+static SweepHit RectangleRectangleSweep(
+    Vector2 positionA,
+    cen::Size sizeA,
+    Vector2 motion,
+    Vector2 positionB,
+    cen::Size sizeB
+) {
+    auto overlap = RectangleRectangleCollision(positionA, sizeA, positionB, sizeB);
+    if (overlap.penetration > 0) {
+        return Vector2DotProduct(motion, overlap.normal) < 0
+            ? SweepHit{ 0, overlap.normal }
+            : SweepMiss;
+    }
+
+    Vector2 halfSize = { (sizeA.width + sizeB.width)/2, (sizeA.height + sizeB.height)/2 };
+
+    float time;
+    Vector2 normal;
+    if (!RayBoxTime(
+        positionA,
+        motion,
+        Vector2Subtract(positionB, halfSize),
+        Vector2Add(positionB, halfSize),
+        time,
+        normal
+    ) || time >= 1) {
+        return SweepMiss;
+    }
+
+    return { time, normal };
+}
+
 // # Nodes
 
 enum class ColliderType {
@@ -141,10 +362,432 @@ class Shape {
     }
 };
 
+static CollisionHit ShapeCollision(
+    const Shape& shapeA,
+    Vector2 positionA,
+    const Shape& shapeB,
+    Vector2 positionB
+) {
+    switch (shapeA.type) {
+        case Shape::Type::RECTANGLE:
+            switch (shapeB.type) {
+                case Shape::Type::RECTANGLE:
+                    return RectangleRectangleCollision(
+                        positionA,
+                        shapeA.rect.size,
+                        positionB,
+                        shapeB.rect.size
+                    );
+                case Shape::Type::CIRCLE:
+                    return CircleRectangleCollision(
+                        positionB,
+                        shapeB.circle.radius,
+                        positionA,
+                        shapeA.rect.size
+                    );
+            }
+            break;
+        case Shape::Type::CIRCLE:
+            switch (shapeB.type) {
+                case Shape::Type::RECTANGLE:
+                    return CircleRectangleCollision(
+                        positionA,
+                        shapeA.circle.radius,
+                        positionB,
+                        shapeB.rect.size
+                    );
+                case Shape::Type::CIRCLE:
+                    return CircleCircleCollision(
+                        positionA,
+                        shapeA.circle.radius,
+                        positionB,
+                        shapeB.circle.radius
+                    );
+            }
+            break;
+    }
+
+    return {
+        0,
+        Vector2{}
+    };
+}
+
+static AABB ShapeBounds(
+    const Shape& shape,
+    Vector2 position
+) {
+    switch (shape.type) {
+        case Shape::Type::RECTANGLE:
+            return {
+                { position.x - shape.rect.size.width/2, position.y - shape.rect.size.height/2 },
+                { position.x + shape.rect.size.width/2, position.y + shape.rect.size.height/2 }
+            };
+        case Shape::Type::CIRCLE:
+            return {
+                { position.x - shape.circle.radius, position.y - shape.circle.radius },
+                { position.x + shape.circle.radius, position.y + shape.circle.radius }
+            };
+    }
+
+    return { position, position };
+}
+
+static bool ShapeContainsPoint(
+    const Shape& shape,
+    Vector2 position,
+    Vector2 point
+) {
+    switch (shape.type) {
+        case Shape::Type::RECTANGLE:
+            return std::abs(point.x - position.x) <= shape.rect.size.width/2 &&
+                std::abs(point.y - position.y) <= shape.rect.size.height/2;
+        case Shape::Type::CIRCLE: {
+            auto distance = Vector2Subtract(point, position);
+            return Vector2DotProduct(distance, distance) <= shape.circle.radius * shape.circle.radius;
+        }
+    }
+
+    return false;
+}
+
+// # Shape in global space (scaled by transform), rectangles stay axis aligned,
+// so rotated rectangle becomes rectangle bounding it (no SAT yet)
+static Shape ShapeTransformed(
+    const Shape& shape,
+    const Transform2D& transform
+) {
+    switch (shape.type) {
+        case Shape::Type::RECTANGLE:
+            return Shape::Rectangle({
+                std::abs(transform.a) * shape.rect.size.width + std::abs(transform.c) * shape.rect.size.height,
+                std::abs(transform.b) * shape.rect.size.width + std::abs(transform.d) * shape.rect.size.height
+            });
+        case Shape::Type::CIRCLE: {
+            auto scale = Vector2Abs(Transform2DScale(transform));
+            return Shape::Circle(shape.circle.radius * std::max(scale.x, scale.y));
+        }
+    }
+
+    return shape;
+}
+
+// # Shape A moving by motion against still shape B (normal points from B to A)
+static SweepHit ShapeSweep(
+    const Shape& shapeA,
+    Vector2 positionA,
+    Vector2 motion,
+    const Shape& shapeB,
+    Vector2 positionB
+) {
+    switch (shapeA.type) {
+        case Shape::Type::RECTANGLE:
+            switch (shapeB.type) {
+                case Shape::Type::RECTANGLE:
+                    return RectangleRectangleSweep(
+                        positionA,
+                        shapeA.rect.size,
+                        motion,
+                        positionB,
+                        shapeB.rect.size
+                    );
+                case Shape::Type::CIRCLE: {
+                    // ## Circle moving backwards against rectangle
+                    auto hit = CircleRectangleSweep(
+                        positionB,
+                        shapeB.circle.radius,
+                        Vector2Negate(motion),
+                        positionA,
+                        shapeA.rect.size
+                    );
+                    return { hit.time, Vector2Negate(hit.normal) };
+                }
+            }
+            break;
+        case Shape::Type::CIRCLE:
+            switch (shapeB.type) {
+                case Shape::Type::RECTANGLE:
+                    return CircleRectangleSweep(
+                        positionA,
+                        shapeA.circle.radius,
+                        motion,
+                        positionB,
+                        shapeB.rect.size
+                    );
+                case Shape::Type::CIRCLE:
+                    return CircleCircleSweep(
+                        positionA,
+                        shapeA.circle.radius,
+                        motion,
+                        positionB,
+                        shapeB.circle.radius
+                    );
+            }
+            break;
+    }
+
+    return SweepMiss;
+}
+
+// # Batched narrowphase
+// Pairs are grouped by shape pair into structure of arrays and tested with
+// SIMD kernels (narrowphase_simd.h), pairs left over are tested with scalar
+// functions. Hits are same as ShapeCollision ones, bit for bit.
+
+class NarrowphaseBatch {
+    private:
+        struct CircleCircleGroup {
+            std::vector<uint32_t> pairs;
+            std::vector<float> positionAX;
+            std::vector<float> positionAY;
+            std::vector<float> radiusA;
+            std::vector<float> positionBX;
+            std::vector<float> positionBY;
+            std::vector<float> radiusB;
+        };
+
+        struct CircleRectangleGroup {
+            std::vector<uint32_t> pairs;
+            std::vector<float> circleX;
+            std::vector<float> circleY;
+            std::vector<float> radius;
+            std::vector<float> rectX;
+            std::vector<float> rectY;
+            std::vector<float> rectWidth;
+            std::vector<float> rectHeight;
+        };
+
+        struct RectangleRectangleGroup {
+            std::vector<uint32_t> pairs;
+            std::vector<float> positionAX;
+            std::vector<float> positionAY;
+            std::vector<float> widthA;
+            std::vector<float> heightA;
+            std::vector<float> positionBX;
+            std::vector<float> positionBY;
+            std::vector<float> widthB;
+            std::vector<float> heightB;
+        };
+
+        CircleCircleGroup circleCircle;
+        CircleRectangleGroup circleRectangle;
+        RectangleRectangleGroup rectangleRectangle;
+
+        // # Kernel output, reused between ticks
+        std::vector<float> penetration;
+        std::vector<float> normalX;
+        std::vector<float> normalY;
+
+        void ResizeResults(size_t count) {
+            this->penetration.resize(count);
+            this->normalX.resize(count);
+            this->normalY.resize(count);
+        }
+
+        NarrowphaseResults Results() {
+            return { this->penetration.data(), this->normalX.data(), this->normalY.data() };
+        }
+
+        void CopyHits(const std::vector<uint32_t>& pairs, size_t count, std::vector<CollisionHit>& hits) {
+            for (size_t i = 0; i < count; i++) {
+                hits[pairs[i]] = { this->penetration[i], Vector2{ this->normalX[i], this->normalY[i] } };
+            }
+        }
+
+        void AddCircleRectangle(uint32_t pair, Vector2 circlePosition, float radius, Vector2 rectPosition, cen::Size rectSize) {
+            auto& group = this->circleRectangle;
+            group.pairs.push_back(pair);
+            group.circleX.push_back(circlePosition.x);
+            group.circleY.push_back(circlePosition.y);
+            group.radius.push_back(radius);
+            group.rectX.push_back(rectPosition.x);
+            group.rectY.push_back(rectPosition.y);
+            group.rectWidth.push_back(rectSize.width);
+            group.rectHeight.push_back(rectSize.height);
+        }
+
+    public:
+        uint32_t pairsCount = 0;
+
+        void Clear() {
+            this->pairsCount = 0;
+
+            this->circleCircle.pairs.clear();
+            this->circleCircle.positionAX.clear();
+            this->circleCircle.positionAY.clear();
+            this->circleCircle.radiusA.clear();
+            this->circleCircle.positionBX.clear();
+            this->circleCircle.positionBY.clear();
+            this->circleCircle.radiusB.clear();
+
+            this->circleRectangle.pairs.clear();
+            this->circleRectangle.circleX.clear();
+            this->circleRectangle.circleY.clear();
+            this->circleRectangle.radius.clear();
+            this->circleRectangle.rectX.clear();
+            this->circleRectangle.rectY.clear();
+            this->circleRectangle.rectWidth.clear();
+            this->circleRectangle.rectHeight.clear();
+
+            this->rectangleRectangle.pairs.clear();
+            this->rectangleRectangle.positionAX.clear();
+            this->rectangleRectangle.positionAY.clear();
+            this->rectangleRectangle.widthA.clear();
+            this->rectangleRectangle.heightA.clear();
+            this->rectangleRectangle.positionBX.clear();
+            this->rectangleRectangle.positionBY.clear();
+            this->rectangleRectangle.widthB.clear();
+            this->rectangleRectangle.heightB.clear();
+        }
+
+        // # Adds pair with next index (arguments same as ShapeCollision)
+        uint32_t Add(
+            const Shape& shapeA,
+            Vector2 positionA,
+            const Shape& shapeB,
+            Vector2 positionB
+        ) {
+            auto pair = this->pairsCount++;
+
+            if (shapeA.type == Shape::Type::CIRCLE && shapeB.type == Shape::Type::CIRCLE) {
+                auto& group = this->circleCircle;
+                group.pairs.push_back(pair);
+                group.positionAX.push_back(positionA.x);
+                group.positionAY.push_back(positionA.y);
+                group.radiusA.push_back(shapeA.circle.radius);
+                group.positionBX.push_back(positionB.x);
+                group.positionBY.push_back(positionB.y);
+                group.radiusB.push_back(shapeB.circle.radius);
+            } else if (shapeA.type == Shape::Type::RECTANGLE && shapeB.type == Shape::Type::RECTANGLE) {
+                auto& group = this->rectangleRectangle;
+                group.pairs.push_back(pair);
+                group.positionAX.push_back(positionA.x);
+                group.positionAY.push_back(positionA.y);
+                group.widthA.push_back(shapeA.rect.size.width);
+                group.heightA.push_back(shapeA.rect.size.height);
+                group.positionBX.push_back(positionB.x);
+                group.positionBY.push_back(positionB.y);
+                group.widthB.push_back(shapeB.rect.size.width);
+                group.heightB.push_back(shapeB.rect.size.height);
+            } else if (shapeA.type == Shape::Type::CIRCLE) {
+                this->AddCircleRectangle(pair, positionA, shapeA.circle.radius, positionB, shapeB.rect.size);
+            } else {
+                this->AddCircleRectangle(pair, positionB, shapeB.circle.radius, positionA, shapeA.rect.size);
+            }
+
+            return pair;
+        }
+
+        // # hits[pair] is hit of every added pair
+        void Run(std::vector<CollisionHit>& hits) {
+            hits.resize(this->pairsCount);
+
+            // # Circle circle
+            {
+                const auto& group = this->circleCircle;
+                auto count = group.pairs.size();
+                this->ResizeResults(count);
+
+                auto done = CircleCircleKernel(
+                    {
+                        group.positionAX.data(),
+                        group.positionAY.data(),
+                        group.radiusA.data(),
+                        group.positionBX.data(),
+                        group.positionBY.data(),
+                        group.radiusB.data()
+                    },
+                    this->Results(),
+                    count
+                );
+                this->CopyHits(group.pairs, done, hits);
+
+                for (auto i = done; i < count; i++) {
+                    hits[group.pairs[i]] = CircleCircleCollision(
+                        Vector2{ group.positionAX[i], group.positionAY[i] },
+                        group.radiusA[i],
+                        Vector2{ group.positionBX[i], group.positionBY[i] },
+                        group.radiusB[i]
+                    );
+                }
+            }
+
+            // # Circle rectangle
+            {
+                const auto& group = this->circleRectangle;
+                auto count = group.pairs.size();
+                this->ResizeResults(count);
+
+                auto done = CircleRectangleKernel(
+                    {
+                        group.circleX.data(),
+                        group.circleY.data(),
+                        group.radius.data(),
+                        group.rectX.data(),
+                        group.rectY.data(),
+                        group.rectWidth.data(),
+                        group.rectHeight.data()
+                    },
+                    this->Results(),
+                    count
+                );
+                this->CopyHits(group.pairs, done, hits);
+
+                for (auto i = done; i < count; i++) {
+                    hits[group.pairs[i]] = CircleRectangleCollision(
+                        Vector2{ group.circleX[i], group.circleY[i] },
+                        group.radius[i],
+                        Vector2{ group.rectX[i], group.rectY[i] },
+                        cen::Size{ group.rectWidth[i], group.rectHeight[i] }
+                    );
+                }
+            }
+
+            // # Rectangle rectangle
+            {
+                const auto& group = this->rectangleRectangle;
+                auto count = group.pairs.size();
+                this->ResizeResults(count);
+
+                auto done = RectangleRectangleKernel(
+                    {
+                        group.positionAX.data(),
+                        group.positionAY.data(),
+                        group.widthA.data(),
+                        group.heightA.data(),
+                        group.positionBX.data(),
+                        group.positionBY.data(),
+                        group.widthB.data(),
+                        group.heightB.data()
+                    },
+                    this->Results(),
+                    count
+                );
+                this->CopyHits(group.pairs, done, hits);
+
+                for (auto i = done; i < count; i++) {
+                    hits[group.pairs[i]] = RectangleRectangleCollision(
+                        Vector2{ group.positionAX[i], group.positionAY[i] },
+                        cen::Size{ group.widthA[i], group.heightA[i] },
+                        Vector2{ group.positionBX[i], group.positionBY[i] },
+                        cen::Size{ group.widthB[i], group.heightB[i] }
+                    );
+                }
+            }
+        }
+};
+
 class Collider: public Node2D {
     public:
         ColliderType type;
         Shape shape;
+        // # Layers collider is on and layers it collides with (see CollisionLayersMatch)
+        uint32_t layer;
+        uint32_t mask;
+        // # Index in CollisionEngine collider entries of last check
+        uint32_t collisionEntry = UINT32_MAX;
+        // # Last CollisionEngine query that tested collider where it is now
+        uint64_t queryStamp = 0;
 
         static const uint64_t _tid;
 
@@ -152,9 +795,28 @@ class Collider: public Node2D {
             return Collider::_tid;
         }
 
-        Collider(ColliderType type, Shape shape, Vector2 position = Vector2{}, int zOrder = 0, uint16_t id = 0, Node* parent = nullptr): Node2D(position, zOrder, id, parent) {
+        Collider(
+            ColliderType type,
+            Shape shape,
+            Vector2 position = Vector2{},
+            int zOrder = 0,
+            uint16_t id = 0,
+            Node* parent = nullptr,
+            uint32_t layer = CollisionLayerDefault,
+            uint32_t mask = CollisionMaskAll
+        ): Node2D(position, zOrder, id, parent) {
             this->type = type;
             this->shape = shape;
+            this->layer = layer;
+            this->mask = mask;
+        }
+
+        bool LayersMatch(const Collider* other) const {
+            return CollisionLayersMatch(this->layer, this->mask, other->layer, other->mask);
+        }
+
+        Shape GlobalShape() {
+            return ShapeTransformed(this->shape, this->GlobalTransform());
         }
 };
 
@@ -171,6 +833,19 @@ struct Collision {
 
 class CollisionObject2D: public Node2D {
     public:
+        // # Static bodies don't move, pairs of two static bodies are never tested.
+        // CollisionEngine caches their colliders (see CollisionEngine::InvalidateStatic)
+        bool isStatic = false;
+
+        // # Body still for CollisionEngine::sleepTicks checks falls asleep, sleeping
+        // bodies are not tested against static and sleeping bodies (last hits are kept)
+        bool canSleep = true;
+        bool sleeping = false;
+        uint32_t stillTicks = 0;
+        // ## Global transform when body came to rest (rotation and scale change collider shapes too)
+        Transform2D restTransform = Transform2D{};
+        size_t restChildrenCount = 0;
+
         static const uint64_t _tid;
 
         cen::type_id_t TypeId() const override {
@@ -179,224 +854,1334 @@ class CollisionObject2D: public Node2D {
 
         CollisionObject2D(Vector2 position, int zOrder = 0, uint16_t id = 0, Node* parent = nullptr): Node2D(position, zOrder, id, parent) {}
         
-        virtual void OnCollision(Collision c) {}
-        virtual void OnCollisionStarted(Collision c) {}
-        virtual void OnCollisionEnded(Collision c) {}
-};
+        void Wake() {
+            this->sleeping = false;
+            this->stillTicks = 0;
+        }
 
-// # Checks
+        // # Index of receiver in CollisionEngine dispatch (valid while dispatchStamp matches)
+        uint64_t dispatchStamp = 0;
+        uint32_t dispatchReceiver = 0;
 
-struct CollisionEvent {
-    CollisionHit hit;
-    CollisionObject2D* collisionObjectA;
-    Collider* colliderA;
-    CollisionObject2D* collisionObjectB;
-    Collider* colliderB;
-};
+        virtual void OnCollision(const Collision& c) {}
+        virtual void OnCollisionStarted(const Collision& c) {}
+        virtual void OnCollisionEnded(const Collision& c) {}
 
-class CollisionEngine {
-    public:
-        // # TODO: change to key value with node.id + node.id as key 
-        std::vector<CollisionEvent> collisions;
-        std::vector<CollisionEvent> startedCollisions;
-        std::vector<CollisionEvent> endedCollisions;
+        // # Every collision of object in check at once (in event order), override
+        // to handle them in batch, by default they are passed one by one
+        virtual void OnCollisions(std::span<const Collision> collisions) {
+            for (const auto& c: collisions) {
+                this->OnCollision(c);
+            }
+        }
 
-        CollisionEngine() {
-            this->collisions = std::vector<CollisionEvent>();
+        virtual void OnCollisionsStarted(std::span<const Collision> collisions) {
+            for (const auto& c: collisions) {
+                this->OnCollisionStarted(c);
+            }
         }
 
-        void NarrowCollisionCheckNaive(
-            cen::NodeStorage* nodeStorage
-        ) {
-            std::vector<CollisionEvent> currentCollisions;
+        virtual void OnCollisionsEnded(std::span<const Collision> collisions) {
+            for (const auto& c: collisions) {
+                this->OnCollisionEnded(c);
+            }
+        }
+};
 
-            for (auto i = 0; i < nodeStorage->flatNodes.size(); i++) {
-                auto node = nodeStorage->flatNodes[i];
+// # Tile map collision
+// Static body over solid tiles of layer. Merged rectangles of tiles are its
+// colliders (for collision checks), sweeps and overlaps of queries look up
+// cells under query bounds directly. Tile map must not be rotated or scaled.
 
-                const auto& co = dynamic_cast<CollisionObject2D*>(node);
-                if (co == nullptr) {
-                    continue;
-                }
+class TileMapCollision2D: public CollisionObject2D {
+    public:
+        int width;
+        int height;
+        cen::Size tileSize;
+        // # Cell y * width + x is solid
+        std::vector<uint8_t> solid;
+        std::vector<TileRect> rects;
+        uint32_t layer;
+        uint32_t mask;
 
-                for (const auto& childNode: co->children) {
-                    auto collider = dynamic_cast<Collider*>(childNode.get());
+        static const uint64_t _tid;
 
-                    if (collider == nullptr) {
-                        continue;
-                    }
+        cen::type_id_t TypeId() const override {
+            return TileMapCollision2D::_tid;
+        }
 
-                    for (auto j = i + 1; j < nodeStorage->flatNodes.size(); j++) {
-                        auto otherNode = nodeStorage->flatNodes[j];
+        // # Position is top left corner of tile map, every non empty tile is solid
+        TileMapCollision2D(
+            Vector2 position,
+            const TileMapLayer& tileLayer,
+            cen::Size tileSize,
+            uint32_t layer = CollisionLayerDefault,
+            uint32_t mask = CollisionMaskAll,
+            int zOrder = 0,
+            uint16_t id = 0,
+            Node* parent = nullptr
+        ): CollisionObject2D(position, zOrder, id, parent) {
+            this->isStatic = true;
+            this->width = tileLayer.width;
+            this->height = tileLayer.height;
+            this->tileSize = tileSize;
+            this->layer = layer;
+            this->mask = mask;
+
+            this->solid.resize(tileLayer.data.size());
+            for (size_t i = 0; i < tileLayer.data.size(); i++) {
+                this->solid[i] = tileLayer.data[i] != 0;
+            }
 
-                        const auto& otherCo = dynamic_cast<CollisionObject2D*>(otherNode);
-                        if (otherCo == nullptr) {
-                            continue;
-                        }
+            MergeSolidTiles(tileLayer, this->rects);
+        }
 
-                        if (co == otherCo) {
-                            continue;
-                        }
+        void Init() override {
+            for (const auto& rect: this->rects) {
+                auto collider = this->AddNode<Collider>(
+                    ColliderType::Solid,
+                    Shape::Rectangle({
+                        rect.width * this->tileSize.width,
+                        rect.height * this->tileSize.height
+                    }),
+                    Vector2{
+                        (rect.x + rect.width / 2.0f) * this->tileSize.width,
+                        (rect.y + rect.height / 2.0f) * this->tileSize.height
+                    }
+                );
+                collider->layer = this->layer;
+                collider->mask = this->mask;
+            }
+        }
 
-                        for (const auto& otherChildNode: otherCo->children) {
-                            auto otherCollider = dynamic_cast<Collider*>(otherChildNode.get());
+        bool IsSolid(int x, int y) const {
+            return x >= 0 && y >= 0 && x < this->width && y < this->height && this->solid[y * this->width + x];
+        }
 
-                            if (otherCollider == nullptr) {
-                                continue;
-                            }
+        // # Calls callback(center) for every solid cell overlapping bounds (global)
+        template <typename F>
+        void ForEachSolidCell(const AABB& bounds, F&& callback) {
+            auto origin = this->GlobalPosition();
 
-                            auto collision = CollisionHit{0, Vector2{}};
-
-                            switch (collider->shape.type) {
-                                case Shape::Type::RECTANGLE:
-                                    switch (otherCollider->shape.type) {
-                                        case Shape::Type::RECTANGLE:
-                                            collision = RectangleRectangleCollision(
-                                                collider->GlobalPosition(),
-                                                collider->shape.rect.size,
-                                                otherCollider->GlobalPosition(),
-                                                otherCollider->shape.rect.size
-                                            );
-                                            break;
-                                        case Shape::Type::CIRCLE:
-                                            collision = CircleRectangleCollision(
-                                                otherCollider->GlobalPosition(),
-                                                otherCollider->shape.circle.radius,
-                                                collider->GlobalPosition(),
-                                                collider->shape.rect.size
-                                            );
-                                            break;
-                                    }
-                                    break;
-                                case Shape::Type::CIRCLE:
-                                    switch (otherCollider->shape.type) {
-                                        case Shape::Type::RECTANGLE:
-                                            collision = CircleRectangleCollision(
-                                                collider->GlobalPosition(),
-                                                collider->shape.circle.radius,
-                                                otherCollider->GlobalPosition(),
-                                                otherCollider->shape.rect.size
-                                            );
-                                            break;
-                                        case Shape::Type::CIRCLE:
-                                            collision = CircleCircleCollision(
-                                                collider->GlobalPosition(),
-                                                collider->shape.circle.radius,
-                                                otherCollider->GlobalPosition(),
-                                                otherCollider->shape.circle.radius
-                                            );
-                                            break;
-                                    }
-                                    break;
-                            }
+            auto minX = std::max(static_cast<int>(std::floor((bounds.min.x - origin.x) / this->tileSize.width)), 0);
+            auto minY = std::max(static_cast<int>(std::floor((bounds.min.y - origin.y) / this->tileSize.height)), 0);
+            auto maxX = std::min(static_cast<int>(std::floor((bounds.max.x - origin.x) / this->tileSize.width)), this->width - 1);
+            auto maxY = std::min(static_cast<int>(std::floor((bounds.max.y - origin.y) / this->tileSize.height)), this->height - 1);
 
-                            if (collision.penetration > 0) {
-                                currentCollisions.push_back({
-                                    collision,
-                                    co,
-                                    collider,
-                                    otherCo,
-                                    otherCollider
-                                });
-                            }
-                        }
-                    } 
+            for (auto y = minY; y <= maxY; y++) {
+                for (auto x = minX; x <= maxX; x++) {
+                    if (!this->solid[y * this->width + x]) {
+                        continue;
+                    }
+
+                    callback(Vector2{
+                        origin.x + (x + 0.5f) * this->tileSize.width,
+                        origin.y + (y + 0.5f) * this->tileSize.height
+                    });
                 }
             }
+        }
 
-            std::vector<CollisionEvent> newCollisions;
+        // # First solid cell hit by shape moving by motion
+        SweepHit Sweep(
+            const Shape& shape,
+            Vector2 position,
+            Vector2 motion
+        ) {
+            auto bounds = AABBUnion(
+                ShapeBounds(shape, position),
+                ShapeBounds(shape, Vector2Add(position, motion))
+            );
+            auto cell = Shape::Rectangle(this->tileSize);
+            SweepHit first = SweepMiss;
+
+            this->ForEachSolidCell(bounds, [&](Vector2 center) {
+                auto hit = ShapeSweep(shape, position, motion, cell, center);
+
+                if (hit.time < first.time) {
+                    first = hit;
+                }
+            });
 
-            for (auto collision: currentCollisions) {
-                bool found = false;
+            return first;
+        }
 
-                for (auto oldCollision: this->collisions) {
-                    if (
-                        (oldCollision.collisionObjectA == collision.collisionObjectB &&
-                        oldCollision.collisionObjectB == collision.collisionObjectA) || 
-                        (oldCollision.collisionObjectA == collision.collisionObjectA &&
-                        oldCollision.collisionObjectB == collision.collisionObjectB)
-                    ) {
-                        found = true;
-                        break;
-                    }
-                }
+        // # Deepest overlap of shape with solid cells
+        CollisionHit Overlap(
+            const Shape& shape,
+            Vector2 position
+        ) {
+            auto cell = Shape::Rectangle(this->tileSize);
+            CollisionHit deepest = { 0, Vector2{} };
 
-                if (!found) {
-                    newCollisions.push_back(collision);
+            this->ForEachSolidCell(ShapeBounds(shape, position), [&](Vector2 center) {
+                auto hit = ShapeCollision(shape, position, cell, center);
+
+                if (hit.penetration > deepest.penetration) {
+                    deepest = hit;
                 }
-            }
+            });
 
-            this->startedCollisions = newCollisions;
+            return deepest;
+        }
+};
 
-            std::vector<CollisionEvent> endedCollisions;
+// # Queries
 
-            for (auto oldCollision: this->collisions) {
-                bool found = false;
+struct QueryFilter {
+    // # Colliders matched like collider on layer with mask (see CollisionLayersMatch)
+    uint32_t layer = 0;
+    uint32_t mask = CollisionMaskAll;
+    // # Body whose colliders are skipped (i.e. one doing the query)
+    const CollisionObject2D* exclude = nullptr;
+    bool sensors = false;
+};
 
-                for (auto collision: currentCollisions) {
-                    if (
-                        (oldCollision.collisionObjectA == collision.collisionObjectB &&
-                        oldCollision.collisionObjectB == collision.collisionObjectA) || 
-                        (oldCollision.collisionObjectA == collision.collisionObjectA &&
-                        oldCollision.collisionObjectB == collision.collisionObjectB)
-                    ) {
-                        found = true;
-                        break;
-                    }
-                }
+struct OverlapHit {
+    CollisionHit hit;
+    CollisionObject2D* collisionObject;
+    Collider* collider;
+};
 
-                if (!found) {
-                    endedCollisions.push_back(oldCollision);
-                }
-            }
+struct CastHit {
+    SweepHit hit;
+    CollisionObject2D* collisionObject;
+    Collider* collider;
+};
 
-            this->endedCollisions = endedCollisions;
+struct QueryHit {
+    CollisionObject2D* collisionObject;
+    Collider* collider;
+};
 
-            for (auto collision: newCollisions) {
-                collision.collisionObjectA->OnCollisionStarted({
-                    collision.hit,
-                    collision.colliderA,
-                    collision.collisionObjectB,
-                    collision.colliderB,
-                });
-                collision.collisionObjectB->OnCollisionStarted({
-                    collision.hit,
-                    collision.colliderB,
-                    collision.collisionObjectA,
-                    collision.colliderA,
-                });
-            }
+struct RaycastQuery {
+    Vector2 origin;
+    Vector2 motion;
+    QueryFilter filter;
+};
 
-            for (auto collision: currentCollisions) {
-                collision.collisionObjectA->OnCollision({
-                    collision.hit,
-                    collision.colliderA,
-                    collision.collisionObjectB,
-                    collision.colliderB,
-                });
-                collision.collisionObjectB->OnCollision({
-                    collision.hit,
-                    collision.colliderB,
-                    collision.collisionObjectA,
-                    collision.colliderA,
-                });
-            }
+struct PointQuery {
+    Vector2 point;
+    QueryFilter filter;
+};
+
+struct AABBQuery {
+    AABB bounds;
+    QueryFilter filter;
+};
+
+// # Buffers of one querying thread, reused between queries to avoid reallocation
+struct QueryScratch {
+    std::vector<uint32_t> found;
+    std::vector<uint32_t> staticFound;
+};
+
+// # Checks
+
+struct CollisionEvent {
+    CollisionHit hit;
+    CollisionObject2D* collisionObjectA;
+    Collider* colliderA;
+    CollisionObject2D* collisionObjectB;
+    Collider* colliderB;
+    // # Kept to detect colliders destroyed since event was created
+    node_id_t colliderAId;
+    node_id_t colliderBId;
+};
+
+class CollisionEngine {
+    private:
+        enum class BodyState {
+            Awake,
+            Sleeping,
+            Static
+        };
+
+        struct ColliderEntry {
+            CollisionObject2D* collisionObject;
+            Collider* collider;
+            Shape shape;
+            Vector2 position;
+            BodyState state;
+            // # Kept to detect colliders destroyed since check
+            node_id_t colliderId;
+        };
+
+        struct StaticRange {
+            uint32_t first;
+            uint32_t count;
+        };
+
+        // # Reused between ticks to avoid reallocation
+        std::vector<ColliderEntry> colliderEntries;
+        std::vector<BroadphaseProxy> proxies;
+        // ## Proxy index -> collider entry index
+        std::vector<uint32_t> proxyEntries;
+        std::vector<BroadphasePair> broadphasePairs;
+        std::vector<BroadphasePair> pairs;
+        std::vector<uint32_t> staticFound;
+        std::vector<CollisionEvent> currentCollisions;
+
+        // # Narrowphase buffers of one worker (pairs first..first + count)
+        struct NarrowphaseContact {
+            uint32_t pair;
+            CollisionHit hit;
+        };
+
+        struct NarrowphaseWorker {
+            uint32_t first;
+            uint32_t count;
+            NarrowphaseBatch batch;
+            std::vector<CollisionHit> hits;
+            std::vector<NarrowphaseContact> contacts;
+        };
+
+        std::vector<NarrowphaseWorker> narrowphaseWorkers;
+        // ## Started on first check with enough pairs
+        std::unique_ptr<WorkerPool> workerPool;
+
+        // # Tests worker range of pairs, reads only collider entries and writes
+        // only worker buffers, so workers don't share anything
+        void NarrowphaseRange(NarrowphaseWorker& worker) {
+            worker.batch.Clear();
+
+            for (auto i = worker.first; i < worker.first + worker.count; i++) {
+                const auto& a = this->colliderEntries[this->pairs[i].a];
+                const auto& b = this->colliderEntries[this->pairs[i].b];
+
+                worker.batch.Add(a.shape, a.position, b.shape, b.position);
+            }
+
+            worker.batch.Run(worker.hits);
+            worker.contacts.clear();
+
+            for (uint32_t i = 0; i < worker.count; i++) {
+                if (worker.hits[i].penetration > 0) {
+                    worker.contacts.push_back({ worker.first + i, worker.hits[i] });
+                }
+            }
+        }
+
+        // # Splits pairs into contiguous ranges (one per worker), ranges are merged
+        // in order, so contacts come in pair order for any number of workers.
+        // Returns number of workers used
+        size_t Narrowphase() {
+            auto pairsCount = static_cast<uint32_t>(this->pairs.size());
+            size_t workers = 1;
+
+            if (this->narrowphaseThreads > 1 && this->narrowphaseMinPairs > 0) {
+                workers = std::clamp<size_t>(pairsCount / this->narrowphaseMinPairs, 1, this->narrowphaseThreads);
+            }
+
+            if (this->narrowphaseWorkers.size() < workers) {
+                this->narrowphaseWorkers.resize(workers);
+            }
+
+            for (size_t worker = 0; worker < workers; worker++) {
+                auto first = static_cast<uint32_t>(pairsCount * worker / workers);
+                auto last = static_cast<uint32_t>(pairsCount * (worker + 1) / workers);
+
+                this->narrowphaseWorkers[worker].first = first;
+                this->narrowphaseWorkers[worker].count = last - first;
+            }
+
+            if (workers == 1) {
+                this->NarrowphaseRange(this->narrowphaseWorkers[0]);
+                return workers;
+            }
+
+            if (this->workerPool == nullptr || this->workerPool->Size() != this->narrowphaseThreads) {
+                this->workerPool = std::make_unique<WorkerPool>(this->narrowphaseThreads);
+            }
+
+            auto task = [this, workers](size_t worker) {
+                if (worker < workers) {
+                    this->NarrowphaseRange(this->narrowphaseWorkers[worker]);
+                }
+            };
+
+            this->workerPool->Run(task);
+
+            return workers;
+        }
+
+        // # Static geometry cache, rebuilt only when static bodies change
+        bool staticDirty = true;
+        uint64_t staticStructureVersion = 0;
+        std::vector<node_id_t> staticObjects;
+        std::vector<size_t> staticChildrenCounts;
+        std::vector<Transform2D> staticTransforms;
+        std::vector<StaticRange> staticRanges;
+        std::vector<ColliderEntry> staticEntries;
+        std::vector<BroadphaseProxy> staticProxies;
+        // ## Static entry index -> collider entry index (of current check)
+        std::vector<uint32_t> staticEntryIndexes;
+        StaticGrid staticGrid;
+
+        // # Every collider of collision object with its global shape and position
+        template <typename F>
+        static void ForEachCollider(CollisionObject2D* co, F&& callback) {
+            for (const auto& childNode: co->children) {
+                auto collider = childNode->As<Collider>();
+
+                if (collider == nullptr) {
+                    continue;
+                }
+
+                // ## Read from cached global transform
+                const auto& transform = collider->GlobalTransform();
+                callback(collider, ShapeTransformed(collider->shape, transform), Transform2DOrigin(transform));
+            }
+        }
+
+        // # Static bodies were added, removed or moved since cache was built
+        bool StaticChanged(cen::NodeStorage* nodeStorage, const std::vector<Node*>& objects) const {
+            // ## Children of static bodies could be added or destroyed
+            if (nodeStorage->structureVersion != this->staticStructureVersion) {
+                for (const auto& proxy: this->staticProxies) {
+                    if (!nodeStorage->IsAlive(proxy.id)) {
+                        return true;
+                    }
+                }
+            }
+
+            size_t staticObject = 0;
+
+            for (auto node: objects) {
+                auto co = static_cast<CollisionObject2D*>(node);
+
+                if (!co->isStatic) {
+                    continue;
+                }
+
+                if (
+                    staticObject >= this->staticObjects.size() ||
+                    this->staticObjects[staticObject] != co->id ||
+                    this->staticChildrenCounts[staticObject] != co->children.size() ||
+                    !Transform2DEqual(this->staticTransforms[staticObject], co->GlobalTransform())
+                ) {
+                    return true;
+                }
+
+                staticObject++;
+            }
+
+            return staticObject != this->staticObjects.size();
+        }
+
+        void RebuildStatic(cen::NodeStorage* nodeStorage, const std::vector<Node*>& objects) {
+            this->staticObjects.clear();
+            this->staticChildrenCounts.clear();
+            this->staticTransforms.clear();
+            this->staticRanges.clear();
+            this->staticEntries.clear();
+            this->staticProxies.clear();
+
+            for (auto node: objects) {
+                auto co = static_cast<CollisionObject2D*>(node);
+
+                if (!co->isStatic) {
+                    // ## Sleeping bodies could rest on geometry that changed
+                    co->Wake();
+                    continue;
+                }
+
+                auto first = static_cast<uint32_t>(this->staticEntries.size());
+
+                ForEachCollider(co, [&](Collider* collider, Shape shape, Vector2 position) {
+                    this->staticEntries.push_back({ co, collider, shape, position, BodyState::Static, collider->id });
+                    this->staticProxies.push_back({ collider->id, ShapeBounds(shape, position), collider->layer, collider->mask });
+                });
+
+                this->staticObjects.push_back(co->id);
+                this->staticChildrenCounts.push_back(co->children.size());
+                this->staticTransforms.push_back(co->GlobalTransform());
+                this->staticRanges.push_back({ first, static_cast<uint32_t>(this->staticEntries.size()) - first });
+            }
+
+            this->staticGrid.Build(this->staticProxies);
+            this->staticEntryIndexes.resize(this->staticEntries.size());
+            this->staticStructureVersion = nodeStorage->structureVersion;
+            this->staticDirty = false;
+        }
+
+        // # Body moved, rotated, scaled (or got new children) since it came to rest is awake
+        void UpdateSleep(CollisionObject2D* co) {
+            const auto& transform = co->GlobalTransform();
+            const auto& rest = co->restTransform;
+            auto moved = std::abs(transform.x - rest.x) > this->sleepThreshold ||
+                std::abs(transform.y - rest.y) > this->sleepThreshold ||
+                transform.a != rest.a || transform.b != rest.b ||
+                transform.c != rest.c || transform.d != rest.d ||
+                co->children.size() != co->restChildrenCount;
+
+            if (moved || !co->canSleep || this->sleepTicks == 0) {
+                co->restTransform = transform;
+                co->restChildrenCount = co->children.size();
+                co->Wake();
+                return;
+            }
+
+            if (!co->sleeping && ++co->stillTicks >= this->sleepTicks) {
+                co->sleeping = true;
+            }
+        }
+
+        // # Collider entry of collider in current check (or UINT32_MAX)
+        uint32_t EntryOf(Collider* collider) const {
+            auto entry = collider->collisionEntry;
+
+            if (entry >= this->colliderEntries.size() || this->colliderEntries[entry].collider != collider) {
+                return UINT32_MAX;
+            }
+
+            return entry;
+        }
+
+        void AddPair(uint32_t a, uint32_t b) {
+            this->pairs.push_back({ std::min(a, b), std::max(a, b) });
+        }
+
+        // # Scratch of ShapeCast / Raycast / OverlapShape, reused between queries
+        QueryScratch queryScratch;
+
+        static bool QueryAccepts(
+            const QueryFilter& filter,
+            const CollisionObject2D* co,
+            const Collider* collider
+        ) {
+            return co != filter.exclude &&
+                (filter.sensors || collider->type != ColliderType::Sensor) &&
+                CollisionLayersMatch(filter.layer, filter.mask, collider->layer, collider->mask);
+        }
+
+        // # Colliders whose bounds overlap bounds where they were in last check, found
+        // by broadphase and static grid, skip(co, collider) leaves colliders out.
+        // Doesn't touch nodes, so it is safe to call from several threads with own scratch.
+        template <typename S, typename F>
+        void ForEachQueryCandidate(
+            cen::NodeStorage* nodeStorage,
+            const AABB& bounds,
+            const QueryFilter& filter,
+            QueryScratch& scratch,
+            S&& skip,
+            F&& callback
+        ) const {
+            auto accepts = [&](const ColliderEntry& entry) {
+                return QueryAccepts(filter, entry.collisionObject, entry.collider) &&
+                    !skip(entry.collisionObject, entry.collider);
+            };
+
+            // ## NarrowCollisionCheckNaive has no acceleration structure
+            if (this->broadphase == nullptr) {
+                for (const auto& entry: this->colliderEntries) {
+                    if (
+                        !nodeStorage->IsAlive(entry.colliderId) ||
+                        !accepts(entry) ||
+                        !AABBOverlap(ShapeBounds(entry.shape, entry.position), bounds)
+                    ) {
+                        continue;
+                    }
+
+                    callback(entry.collisionObject, entry.collider, entry.shape, entry.position);
+                }
+
+                return;
+            }
+
+            scratch.found.clear();
+            this->broadphase->Query(bounds, scratch.found);
+
+            // ## Broadphase may report proxy more than once, proxy order keeps queries deterministic
+            std::sort(scratch.found.begin(), scratch.found.end());
+            scratch.found.erase(
+                std::unique(scratch.found.begin(), scratch.found.end()),
+                scratch.found.end()
+            );
+
+            for (auto proxy: scratch.found) {
+                if (proxy >= this->proxies.size() || !nodeStorage->IsAlive(this->proxies[proxy].id)) {
+                    continue;
+                }
+
+                const auto& entry = this->colliderEntries[this->proxyEntries[proxy]];
+
+                if (!accepts(entry) || !AABBOverlap(ShapeBounds(entry.shape, entry.position), bounds)) {
+                    continue;
+                }
+
+                callback(entry.collisionObject, entry.collider, entry.shape, entry.position);
+            }
+
+            scratch.staticFound.clear();
+            this->staticGrid.Query({ 0, bounds, filter.layer, filter.mask }, scratch.staticFound);
+
+            for (auto staticEntry: scratch.staticFound) {
+                const auto& entry = this->staticEntries[staticEntry];
+
+                if (!nodeStorage->IsAlive(entry.colliderId) || !accepts(entry)) {
+                    continue;
+                }
+
+                callback(entry.collisionObject, entry.collider, entry.shape, entry.position);
+            }
+        }
+
+        template <typename F>
+        void ForEachQueryCandidate(
+            cen::NodeStorage* nodeStorage,
+            const AABB& bounds,
+            const QueryFilter& filter,
+            QueryScratch& scratch,
+            F&& callback
+        ) const {
+            auto none = [](const CollisionObject2D*, const Collider*) {
+                return false;
+            };
+
+            this->ForEachQueryCandidate(nodeStorage, bounds, filter, scratch, none, callback);
+        }
+
+        // # Stamp of current query, colliders tested where they are now carry it
+        uint64_t currentQueryStamp = 0;
+
+        // # Colliders whose bounds overlap bounds where they are now. Colliders added
+        // or moved since last check (NodeStorage::transformChanges) are tested directly,
+        // the rest didn't move, so they are found by broadphase and static grid.
+        template <typename F>
+        void ForEachCurrentQueryCandidate(
+            cen::NodeStorage* nodeStorage,
+            const AABB& bounds,
+            const QueryFilter& filter,
+            QueryScratch& scratch,
+            F&& callback
+        ) {
+            auto stamp = ++this->currentQueryStamp;
+
+            for (size_t i = 0; i < nodeStorage->transformChanges.size(); i++) {
+                auto node = nodeStorage->GetById(nodeStorage->transformChanges[i]);
+                auto collider = node == nullptr ? nullptr : node->As<Collider>();
+
+                if (collider == nullptr || collider->parent == nullptr) {
+                    continue;
+                }
+
+                auto co = collider->parent->As<CollisionObject2D>();
+
+                // ## Tile maps are looked up by cells (see ForEachQueryTileMap)
+                if (co == nullptr || co->IsA<TileMapCollision2D>()) {
+                    continue;
+                }
+
+                collider->queryStamp = stamp;
+
+                if (!QueryAccepts(filter, co, collider)) {
+                    continue;
+                }
+
+                auto shape = collider->GlobalShape();
+                auto position = collider->GlobalPosition();
+
+                if (AABBOverlap(ShapeBounds(shape, position), bounds)) {
+                    callback(co, collider, shape, position);
+                }
+            }
+
+            auto skip = [stamp](const CollisionObject2D* co, const Collider* collider) {
+                return collider->queryStamp == stamp || co->IsA<TileMapCollision2D>();
+            };
+
+            this->ForEachQueryCandidate(nodeStorage, bounds, filter, scratch, skip, callback);
+        }
+
+        // # Tile maps matching filter (queries reading current shapes test their cells
+        // instead of their colliders)
+        template <typename F>
+        static void ForEachQueryTileMap(
+            cen::NodeStorage* nodeStorage,
+            const QueryFilter& filter,
+            F&& callback
+        ) {
+            for (auto node: nodeStorage->GetAllByType<TileMapCollision2D>()) {
+                auto tileMap = static_cast<TileMapCollision2D*>(node);
+
+                if (tileMap == filter.exclude || !CollisionLayersMatch(filter.layer, filter.mask, tileMap->layer, tileMap->mask)) {
+                    continue;
+                }
+
+                callback(tileMap);
+            }
+        }
+
+        // # Inserts hit keeping hits sorted by time (first found goes first on same
+        // time), returns new count
+        static size_t InsertCastHit(
+            CastHit* hits,
+            size_t count,
+            size_t maxHits,
+            const CastHit& hit
+        ) {
+            if (count == maxHits) {
+                if (hit.hit.time >= hits[count - 1].hit.time) {
+                    return count;
+                }
+                count--;
+            }
+
+            auto i = count++;
+            for (; i > 0 && hits[i - 1].hit.time > hit.hit.time; i--) {
+                hits[i] = hits[i - 1];
+            }
+
+            hits[i] = hit;
+            return count;
+        }
+
+        // # Runs query for every entry of batch, query i writes hits from i * maxHitsPerQuery
+        template <typename Query, typename Hit, typename Run>
+        static void RunBatch(
+            const Query* queries,
+            size_t count,
+            Hit* hits,
+            size_t maxHitsPerQuery,
+            size_t* hitCounts,
+            Run&& run
+        ) {
+            for (size_t i = 0; i < count; i++) {
+                hitCounts[i] = run(queries[i], hits + i * maxHitsPerQuery, maxHitsPerQuery);
+            }
+        }
+
+        // # Dispatch scratch, reused between ticks, so steady state dispatch doesn't allocate
+        struct DispatchReceiver {
+            CollisionObject2D* collisionObject;
+            uint32_t first;
+            uint32_t count;
+        };
+
+        std::vector<DispatchReceiver> dispatchReceivers;
+        std::vector<Collision> dispatchCollisions;
+        uint64_t dispatchStamp = 0;
+
+        // # Groups both sides of every event by receiving object (objects in order of
+        // first event, collisions of object in event order) and calls handler once
+        // per object with all of its collisions
+        void Dispatch(
+            const std::vector<CollisionEvent>& events,
+            void (CollisionObject2D::*handler)(std::span<const Collision>)
+        ) {
+            if (events.empty()) {
+                return;
+            }
+
+            this->dispatchStamp++;
+            this->dispatchReceivers.clear();
+
+            auto receiverOf = [this](CollisionObject2D* co) -> DispatchReceiver& {
+                if (co->dispatchStamp != this->dispatchStamp) {
+                    co->dispatchStamp = this->dispatchStamp;
+                    co->dispatchReceiver = static_cast<uint32_t>(this->dispatchReceivers.size());
+                    this->dispatchReceivers.push_back({ co, 0, 0 });
+                }
+
+                return this->dispatchReceivers[co->dispatchReceiver];
+            };
+
+            // # Count collisions of every receiver
+            for (const auto& event: events) {
+                receiverOf(event.collisionObjectA).count++;
+                receiverOf(event.collisionObjectB).count++;
+            }
+
+            uint32_t first = 0;
+            for (auto& receiver: this->dispatchReceivers) {
+                receiver.first = first;
+                first += receiver.count;
+                receiver.count = 0;
+            }
+
+            // # Place collisions in ranges of receivers
+            this->dispatchCollisions.resize(first);
+
+            for (const auto& event: events) {
+                auto& receiverA = this->dispatchReceivers[event.collisionObjectA->dispatchReceiver];
+                this->dispatchCollisions[receiverA.first + receiverA.count++] = {
+                    event.hit,
+                    event.colliderA,
+                    event.collisionObjectB,
+                    event.colliderB,
+                };
+
+                auto& receiverB = this->dispatchReceivers[event.collisionObjectB->dispatchReceiver];
+                this->dispatchCollisions[receiverB.first + receiverB.count++] = {
+                    event.hit,
+                    event.colliderB,
+                    event.collisionObjectA,
+                    event.colliderA,
+                };
+            }
+
+            for (const auto& receiver: this->dispatchReceivers) {
+                (receiver.collisionObject->*handler)(std::span<const Collision>(
+                    this->dispatchCollisions.data() + receiver.first,
+                    receiver.count
+                ));
+            }
+        }
+
+        // # Object pairs colliding in last frames
+        CollisionPairTable pairTable;
+        uint64_t frame = 0;
+
+        void DispatchCollisions(
+            cen::NodeStorage* nodeStorage
+        ) {
+            this->frame++;
+
+            this->startedCollisions.clear();
+            this->endedCollisions.clear();
+
+            for (const auto& collision: this->currentCollisions) {
+                auto started = this->pairTable.Visit(
+                    collision.collisionObjectA->id,
+                    collision.collisionObjectB->id,
+                    this->frame
+                );
 
-            for (auto collision: endedCollisions) {
-                collision.collisionObjectA->OnCollisionEnded({
-                    collision.hit,
-                    collision.colliderA,
-                    collision.collisionObjectB,
-                    collision.colliderB,
+                if (started) {
+                    this->startedCollisions.push_back(collision);
+                }
+            }
+
+            for (const auto& oldCollision: this->collisions) {
+                // ## Destroyed nodes get no ended event
+                if (!nodeStorage->IsAlive(oldCollision.colliderAId) || !nodeStorage->IsAlive(oldCollision.colliderBId)) {
+                    continue;
+                }
+
+                auto active = this->pairTable.IsActive(
+                    oldCollision.collisionObjectA->id,
+                    oldCollision.collisionObjectB->id,
+                    this->frame
+                );
+
+                if (!active) {
+                    this->endedCollisions.push_back(oldCollision);
+                }
+            }
+
+            this->pairTable.Sweep(this->frame);
+
+            this->Dispatch(this->startedCollisions, &CollisionObject2D::OnCollisionsStarted);
+            this->Dispatch(this->currentCollisions, &CollisionObject2D::OnCollisions);
+            this->Dispatch(this->endedCollisions, &CollisionObject2D::OnCollisionsEnded);
+
+            std::swap(this->collisions, this->currentCollisions);
+        }
+
+    public:
+        std::vector<CollisionEvent> collisions;
+        std::vector<CollisionEvent> startedCollisions;
+        std::vector<CollisionEvent> endedCollisions;
+
+        // # nullptr means NarrowCollisionCheckNaive
+        std::unique_ptr<Broadphase> broadphase;
+
+        // # Threads narrowphase is split between (counting simulation thread),
+        // each gets at least narrowphaseMinPairs pairs
+        size_t narrowphaseThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        size_t narrowphaseMinPairs = 256;
+
+        // # Checks body must stay within sleepThreshold to fall asleep (0 disables sleeping)
+        uint32_t sleepTicks = 60;
+        float sleepThreshold = 0;
+
+        CollisionEngine(
+            std::unique_ptr<Broadphase> broadphase = std::make_unique<SpatialHashGrid>()
+        ) {
+            this->collisions = std::vector<CollisionEvent>();
+            this->broadphase = std::move(broadphase);
+        }
+
+        // # Static colliders are gathered again in next check (call after static
+        // collider was changed or moved without moving its body)
+        void InvalidateStatic() {
+            this->staticDirty = true;
+        }
+
+        // # Shape moving by motion, writes up to maxHits first hits sorted by time,
+        // returns their count (tile map gives its first hit, with nullptr collider). Bodies are
+        // tested where they are now, also ones moved or added since last check (direct writes
+        // to position are noticed when node transform is read or in UpdateGlobalTransforms).
+        size_t ShapeCast(
+            cen::NodeStorage* nodeStorage,
+            const Shape& shape,
+            Vector2 position,
+            Vector2 motion,
+            const QueryFilter& filter,
+            CastHit* hits,
+            size_t maxHits
+        ) {
+            if (maxHits == 0) {
+                return 0;
+            }
+
+            auto bounds = AABBUnion(
+                ShapeBounds(shape, position),
+                ShapeBounds(shape, Vector2Add(position, motion))
+            );
+
+            size_t count = 0;
+
+            this->ForEachCurrentQueryCandidate(nodeStorage, bounds, filter, this->queryScratch, [&](CollisionObject2D* co, Collider* collider, const Shape& otherShape, Vector2 otherPosition) {
+                auto hit = ShapeSweep(shape, position, motion, otherShape, otherPosition);
+
+                if (hit.Hit()) {
+                    count = InsertCastHit(hits, count, maxHits, { hit, co, collider });
+                }
+            });
+
+            ForEachQueryTileMap(nodeStorage, filter, [&](TileMapCollision2D* tileMap) {
+                auto hit = tileMap->Sweep(shape, position, motion);
+
+                if (hit.Hit()) {
+                    count = InsertCastHit(hits, count, maxHits, { hit, tileMap, nullptr });
+                }
+            });
+
+            return count;
+        }
+
+        // # First collider hit by ray origin + motion * time (time in 0..1)
+        bool Raycast(
+            cen::NodeStorage* nodeStorage,
+            Vector2 origin,
+            Vector2 motion,
+            const QueryFilter& filter,
+            CastHit& hit
+        ) {
+            return this->ShapeCast(nodeStorage, Shape::Circle(0), origin, motion, filter, &hit, 1) > 0;
+        }
+
+        // # Writes up to maxHits colliders overlapping shape, returns their count
+        // (tile map gives its deepest overlap, with nullptr collider)
+        size_t OverlapShape(
+            cen::NodeStorage* nodeStorage,
+            const Shape& shape,
+            Vector2 position,
+            const QueryFilter& filter,
+            OverlapHit* hits,
+            size_t maxHits
+        ) {
+            size_t count = 0;
+
+            this->ForEachCurrentQueryCandidate(nodeStorage, ShapeBounds(shape, position), filter, this->queryScratch, [&](CollisionObject2D* co, Collider* collider, const Shape& otherShape, Vector2 otherPosition) {
+                if (count == maxHits) {
+                    return;
+                }
+
+                auto hit = ShapeCollision(shape, position, otherShape, otherPosition);
+
+                if (hit.penetration > 0) {
+                    hits[count++] = { hit, co, collider };
+                }
+            });
+
+            ForEachQueryTileMap(nodeStorage, filter, [&](TileMapCollision2D* tileMap) {
+                if (count == maxHits) {
+                    return;
+                }
+
+                auto hit = tileMap->Overlap(shape, position);
+
+                if (hit.penetration > 0) {
+                    hits[count++] = { hit, tileMap, nullptr };
+                }
+            });
+
+            return count;
+        }
+
+        // # World queries
+        // Read colliders where they were in last check and never touch nodes, so
+        // any number of threads (each with own QueryScratch) can query at once
+        // while no check runs. Hits are written into caller buffers.
+
+        // # Every collider hit by ray origin + motion * time (time in 0..1), writes
+        // up to maxHits first hits sorted by time, returns their count
+        size_t RaycastAll(
+            cen::NodeStorage* nodeStorage,
+            const RaycastQuery& query,
+            QueryScratch& scratch,
+            CastHit* hits,
+            size_t maxHits
+        ) const {
+            if (maxHits == 0) {
+                return 0;
+            }
+
+            auto point = Shape::Circle(0);
+            auto bounds = AABBUnion(
+                ShapeBounds(point, query.origin),
+                ShapeBounds(point, Vector2Add(query.origin, query.motion))
+            );
+
+            size_t count = 0;
+
+            this->ForEachQueryCandidate(nodeStorage, bounds, query.filter, scratch, [&](CollisionObject2D* co, Collider* collider, const Shape& shape, Vector2 position) {
+                auto hit = ShapeSweep(point, query.origin, query.motion, shape, position);
+
+                if (hit.Hit()) {
+                    count = InsertCastHit(hits, count, maxHits, { hit, co, collider });
+                }
+            });
+
+            return count;
+        }
+
+        // # Colliders containing point, in collider order of last check
+        size_t QueryPoint(
+            cen::NodeStorage* nodeStorage,
+            const PointQuery& query,
+            QueryScratch& scratch,
+            QueryHit* hits,
+            size_t maxHits
+        ) const {
+            size_t count = 0;
+
+            this->ForEachQueryCandidate(nodeStorage, { query.point, query.point }, query.filter, scratch, [&](CollisionObject2D* co, Collider* collider, const Shape& shape, Vector2 position) {
+                if (count < maxHits && ShapeContainsPoint(shape, position, query.point)) {
+                    hits[count++] = { co, collider };
+                }
+            });
+
+            return count;
+        }
+
+        // # Colliders overlapping bounds, in collider order of last check
+        size_t QueryAABB(
+            cen::NodeStorage* nodeStorage,
+            const AABBQuery& query,
+            QueryScratch& scratch,
+            QueryHit* hits,
+            size_t maxHits
+        ) const {
+            auto boundsShape = Shape::Rectangle({
+                query.bounds.max.x - query.bounds.min.x,
+                query.bounds.max.y - query.bounds.min.y
+            });
+            auto boundsCenter = Vector2Scale(Vector2Add(query.bounds.min, query.bounds.max), 0.5f);
+
+            size_t count = 0;
+
+            this->ForEachQueryCandidate(nodeStorage, query.bounds, query.filter, scratch, [&](CollisionObject2D* co, Collider* collider, const Shape& shape, Vector2 position) {
+                if (count < maxHits && ShapeCollision(boundsShape, boundsCenter, shape, position).penetration > 0) {
+                    hits[count++] = { co, collider };
+                }
+            });
+
+            return count;
+        }
+
+        // # Batches, query i writes hits from hits + i * maxHitsPerQuery and their
+        // count into hitCounts[i] (split batch between threads to run it in parallel)
+        void RaycastBatch(
+            cen::NodeStorage* nodeStorage,
+            const RaycastQuery* queries,
+            size_t count,
+            QueryScratch& scratch,
+            CastHit* hits,
+            size_t maxHitsPerQuery,
+            size_t* hitCounts
+        ) const {
+            RunBatch(queries, count, hits, maxHitsPerQuery, hitCounts, [&](const RaycastQuery& query, CastHit* queryHits, size_t maxHits) {
+                return this->RaycastAll(nodeStorage, query, scratch, queryHits, maxHits);
+            });
+        }
+
+        void QueryPointBatch(
+            cen::NodeStorage* nodeStorage,
+            const PointQuery* queries,
+            size_t count,
+            QueryScratch& scratch,
+            QueryHit* hits,
+            size_t maxHitsPerQuery,
+            size_t* hitCounts
+        ) const {
+            RunBatch(queries, count, hits, maxHitsPerQuery, hitCounts, [&](const PointQuery& query, QueryHit* queryHits, size_t maxHits) {
+                return this->QueryPoint(nodeStorage, query, scratch, queryHits, maxHits);
+            });
+        }
+
+        void QueryAABBBatch(
+            cen::NodeStorage* nodeStorage,
+            const AABBQuery* queries,
+            size_t count,
+            QueryScratch& scratch,
+            QueryHit* hits,
+            size_t maxHitsPerQuery,
+            size_t* hitCounts
+        ) const {
+            RunBatch(queries, count, hits, maxHitsPerQuery, hitCounts, [&](const AABBQuery& query, QueryHit* queryHits, size_t maxHits) {
+                return this->QueryAABB(nodeStorage, query, scratch, queryHits, maxHits);
+            });
+        }
+
+        void CollisionCheck(
+            cen::NodeStorage* nodeStorage
+        ) {
+            // # Queries test nodes moved from here on where they are now
+            nodeStorage->ClearTransformChanges();
+
+            if (this->broadphase == nullptr) {
+                this->NarrowCollisionCheckNaive(nodeStorage);
+                return;
+            }
+
+            this->BroadphaseCollisionCheck(nodeStorage);
+        }
+
+        void BroadphaseCollisionCheck(
+            cen::NodeStorage* nodeStorage
+        ) {
+            this->colliderEntries.clear();
+            this->proxies.clear();
+            this->proxyEntries.clear();
+            this->broadphasePairs.clear();
+            this->pairs.clear();
+
+            const auto& objects = nodeStorage->GetAllByType<CollisionObject2D>();
+
+            if (this->staticDirty || this->StaticChanged(nodeStorage, objects)) {
+                this->RebuildStatic(nodeStorage, objects);
+            }
+
+            // ## Static colliders are all alive, skip checking them till structure changes again
+            this->staticStructureVersion = nodeStorage->structureVersion;
+
+            // # Gather colliders (same order as NarrowCollisionCheckNaive)
+            size_t staticObject = 0;
+
+            for (auto node: objects) {
+                auto co = static_cast<CollisionObject2D*>(node);
+
+                // ## Static colliders are copied from cache
+                if (co->isStatic) {
+                    const auto& range = this->staticRanges[staticObject++];
+
+                    for (auto i = range.first; i < range.first + range.count; i++) {
+                        auto entry = static_cast<uint32_t>(this->colliderEntries.size());
+                        this->staticEntryIndexes[i] = entry;
+                        this->staticEntries[i].collider->collisionEntry = entry;
+                        this->colliderEntries.push_back(this->staticEntries[i]);
+                    }
+
+                    continue;
+                }
+
+                this->UpdateSleep(co);
+                auto state = co->sleeping ? BodyState::Sleeping : BodyState::Awake;
+
+                ForEachCollider(co, [&](Collider* collider, Shape shape, Vector2 position) {
+                    auto entry = static_cast<uint32_t>(this->colliderEntries.size());
+                    collider->collisionEntry = entry;
+
+                    this->colliderEntries.push_back({ co, collider, shape, position, state, collider->id });
+                    this->proxies.push_back({ collider->id, ShapeBounds(shape, position), collider->layer, collider->mask });
+                    this->proxyEntries.push_back(entry);
                 });
-                collision.collisionObjectB->OnCollisionEnded({
-                    collision.hit,
-                    collision.colliderB,
-                    collision.collisionObjectA,
-                    collision.colliderA,
+            }
+
+            // # Broadphase of awake and sleeping bodies
+            this->broadphase->FindPairs(this->proxies, this->broadphasePairs);
+
+            for (const auto& pair: this->broadphasePairs) {
+                auto a = this->proxyEntries[pair.a];
+                auto b = this->proxyEntries[pair.b];
+
+                // ## Pairs of sleeping bodies are kept from last check
+                if (
+                    this->colliderEntries[a].state == BodyState::Sleeping &&
+                    this->colliderEntries[b].state == BodyState::Sleeping
+                ) {
+                    continue;
+                }
+
+                this->AddPair(a, b);
+            }
+
+            // # Awake bodies against static geometry
+            for (uint32_t i = 0; i < this->proxies.size(); i++) {
+                auto entry = this->proxyEntries[i];
+
+                if (this->colliderEntries[entry].state != BodyState::Awake) {
+                    continue;
+                }
+
+                this->staticFound.clear();
+                this->staticGrid.Query(this->proxies[i], this->staticFound);
+
+                for (auto staticEntry: this->staticFound) {
+                    this->AddPair(entry, this->staticEntryIndexes[staticEntry]);
+                }
+            }
+
+            // # Nothing moved between sleeping bodies and static geometry, so they collide
+            // same as in last check
+            for (const auto& collision: this->collisions) {
+                if (!nodeStorage->IsAlive(collision.colliderAId) || !nodeStorage->IsAlive(collision.colliderBId)) {
+                    continue;
+                }
+
+                auto a = this->EntryOf(collision.colliderA);
+                auto b = this->EntryOf(collision.colliderB);
+
+                if (a == UINT32_MAX || b == UINT32_MAX) {
+                    continue;
+                }
+
+                if (
+                    this->colliderEntries[a].state == BodyState::Awake ||
+                    this->colliderEntries[b].state == BodyState::Awake
+                ) {
+                    continue;
+                }
+
+                this->AddPair(a, b);
+            }
+
+            // # Keep NarrowCollisionCheckNaive order to stay deterministic
+            std::sort(this->pairs.begin(), this->pairs.end());
+
+            // # Colliders of same object never collide
+            this->pairs.erase(
+                std::remove_if(
+                    this->pairs.begin(),
+                    this->pairs.end(),
+                    [this](const BroadphasePair& pair) {
+                        return this->colliderEntries[pair.a].collisionObject == this->colliderEntries[pair.b].collisionObject;
+                    }
+                ),
+                this->pairs.end()
+            );
+
+            // # Narrowphase (batched, split between workers)
+            auto workers = this->Narrowphase();
+
+            this->currentCollisions.clear();
+
+            // # Merge worker contacts in pair order (same events as single thread)
+            for (size_t worker = 0; worker < workers; worker++) {
+                for (const auto& contact: this->narrowphaseWorkers[worker].contacts) {
+                    const auto& hit = contact.hit;
+                    const auto& a = this->colliderEntries[this->pairs[contact.pair].a];
+                    const auto& b = this->colliderEntries[this->pairs[contact.pair].b];
+
+                    // ## Touched by awake body
+                    if (a.state == BodyState::Awake && b.state == BodyState::Sleeping) {
+                        b.collisionObject->Wake();
+                    } else if (a.state == BodyState::Sleeping && b.state == BodyState::Awake) {
+                        a.collisionObject->Wake();
+                    }
+
+                    this->currentCollisions.push_back({
+                        hit,
+                        a.collisionObject,
+                        a.collider,
+                        b.collisionObject,
+                        b.collider,
+                        a.collider->id,
+                        b.collider->id
+                    });
+                }
+            }
+
+            this->DispatchCollisions(nodeStorage);
+        }
+
+        // # Reference implementation, compares every collider with every other one
+        void NarrowCollisionCheckNaive(
+            cen::NodeStorage* nodeStorage
+        ) {
+            // # Colliders of this check for world queries
+            this->colliderEntries.clear();
+
+            for (auto node: nodeStorage->GetAllByType<CollisionObject2D>()) {
+                auto co = static_cast<CollisionObject2D*>(node);
+
+                ForEachCollider(co, [&](Collider* collider, Shape shape, Vector2 position) {
+                    this->colliderEntries.push_back({ co, collider, shape, position, BodyState::Awake, collider->id });
                 });
             }
 
-            this->collisions = currentCollisions;
+            this->currentCollisions.clear();
+
+            for (auto i = 0; i < nodeStorage->flatNodes.size(); i++) {
+                auto node = nodeStorage->flatNodes[i];
+
+                const auto& co = node->As<CollisionObject2D>();
+                if (co == nullptr) {
+                    continue;
+                }
+
+                for (const auto& childNode: co->children) {
+                    auto collider = childNode->As<Collider>();
+
+                    if (collider == nullptr) {
+                        continue;
+                    }
+
+                    for (auto j = i + 1; j < nodeStorage->flatNodes.size(); j++) {
+                        auto otherNode = nodeStorage->flatNodes[j];
+
+                        const auto& otherCo = otherNode->As<CollisionObject2D>();
+                        if (otherCo == nullptr) {
+                            continue;
+                        }
+
+                        if (co == otherCo) {
+                            continue;
+                        }
+
+                        if (co->isStatic && otherCo->isStatic) {
+                            continue;
+                        }
+
+                        for (const auto& otherChildNode: otherCo->children) {
+                            auto otherCollider = otherChildNode->As<Collider>();
+
+                            if (otherCollider == nullptr) {
+                                continue;
+                            }
+
+                            if (!collider->LayersMatch(otherCollider)) {
+                                continue;
+                            }
+
+                            auto collision = ShapeCollision(
+                                collider->GlobalShape(),
+                                collider->GlobalPosition(),
+                                otherCollider->GlobalShape(),
+                                otherCollider->GlobalPosition()
+                            );
+
+                            if (collision.penetration > 0) {
+                                this->currentCollisions.push_back({
+                                    collision,
+                                    co,
+                                    collider,
+                                    otherCo,
+                                    otherCollider,
+                                    collider->id,
+                                    otherCollider->id
+                                });
+                            }
+                        }
+                    } 
+                }
+            }
+
+            this->DispatchCollisions(nodeStorage);
         }
 };
 
@@ -0,0 +1,185 @@
+#ifndef CENGINE_COLLISION_PAIR_TABLE_H
+#define CENGINE_COLLISION_PAIR_TABLE_H
+
+#include <vector>
+#include "core.h"
+
+namespace cen {
+
+// # Collision pair table
+// Open addressing hash table keyed on ordered (node_id_t, node_id_t) pairs.
+// Every entry is stamped with the frame it was last seen in, entries not
+// seen in the current frame are dropped by Sweep. Storage is reused, so
+// steady state doesn't allocate.
+
+class CollisionPairTable {
+    private:
+        enum class SlotState: uint8_t {
+            EMPTY,
+            USED,
+            DELETED
+        };
+
+        struct Slot {
+            node_id_t a;
+            node_id_t b;
+            uint64_t startedAt;
+            uint64_t lastSeen;
+            SlotState state;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<Slot> rehashSlots;
+        size_t used = 0;
+        size_t deleted = 0;
+
+        static uint64_t Hash(node_id_t a, node_id_t b) {
+            // # splitmix64 finalizer
+            uint64_t h = a * 0x9E3779B97F4A7C15ull ^ b;
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+            return h ^ (h >> 31);
+        }
+
+        static void Order(node_id_t& a, node_id_t& b) {
+            if (a > b) {
+                std::swap(a, b);
+            }
+        }
+
+        size_t Mask() const {
+            return this->slots.size() - 1;
+        }
+
+        // # Slot holding the pair or nullptr
+        Slot* Find(node_id_t a, node_id_t b) {
+            if (this->slots.empty()) {
+                return nullptr;
+            }
+
+            auto index = Hash(a, b) & this->Mask();
+
+            while (true) {
+                auto& slot = this->slots[index];
+
+                if (slot.state == SlotState::EMPTY) {
+                    return nullptr;
+                }
+
+                if (slot.state == SlotState::USED && slot.a == a && slot.b == b) {
+                    return &slot;
+                }
+
+                index = (index + 1) & this->Mask();
+            }
+        }
+
+        Slot& Insert(node_id_t a, node_id_t b) {
+            if ((this->used + this->deleted + 1) * 4 > this->slots.size() * 3) {
+                this->Rehash(
+                    (this->used + 1) * 2 > this->slots.size()
+                        ? std::max<size_t>(this->slots.size() * 2, 64)
+                        : this->slots.size()
+                );
+            }
+
+            auto index = Hash(a, b) & this->Mask();
+
+            while (this->slots[index].state == SlotState::USED) {
+                index = (index + 1) & this->Mask();
+            }
+
+            auto& slot = this->slots[index];
+            if (slot.state == SlotState::DELETED) {
+                this->deleted--;
+            }
+
+            slot.a = a;
+            slot.b = b;
+            slot.state = SlotState::USED;
+            this->used++;
+
+            return slot;
+        }
+
+        void Rehash(size_t capacity) {
+            this->rehashSlots.assign(capacity, Slot{ 0, 0, 0, 0, SlotState::EMPTY });
+
+            auto mask = capacity - 1;
+
+            for (const auto& slot: this->slots) {
+                if (slot.state != SlotState::USED) {
+                    continue;
+                }
+
+                auto index = Hash(slot.a, slot.b) & mask;
+                while (this->rehashSlots[index].state == SlotState::USED) {
+                    index = (index + 1) & mask;
+                }
+
+                this->rehashSlots[index] = slot;
+            }
+
+            std::swap(this->slots, this->rehashSlots);
+            this->deleted = 0;
+        }
+
+    public:
+        CollisionPairTable(size_t capacity = 64) {
+            // # Capacity must be power of two
+            size_t powerOfTwo = 1;
+            while (powerOfTwo < capacity) {
+                powerOfTwo <<= 1;
+            }
+
+            this->slots.assign(powerOfTwo, Slot{ 0, 0, 0, 0, SlotState::EMPTY });
+        }
+
+        // # Marks pair as seen in frame, returns true if pair started in frame
+        bool Visit(node_id_t a, node_id_t b, uint64_t frame) {
+            Order(a, b);
+
+            auto slot = this->Find(a, b);
+
+            if (slot == nullptr) {
+                slot = &this->Insert(a, b);
+                slot->startedAt = frame;
+            }
+
+            slot->lastSeen = frame;
+
+            return slot->startedAt == frame;
+        }
+
+        bool IsActive(node_id_t a, node_id_t b, uint64_t frame) {
+            Order(a, b);
+
+            auto slot = this->Find(a, b);
+
+            return slot != nullptr && slot->lastSeen == frame;
+        }
+
+        // # Drops pairs not seen in frame
+        void Sweep(uint64_t frame) {
+            for (auto& slot: this->slots) {
+                if (slot.state == SlotState::USED && slot.lastSeen != frame) {
+                    slot.state = SlotState::DELETED;
+                    this->used--;
+                    this->deleted++;
+                }
+            }
+
+            // # Too many tombstones make probing long, rehash in place
+            if (this->deleted * 4 > this->slots.size()) {
+                this->Rehash(this->slots.size());
+            }
+        }
+
+        size_t Size() const {
+            return this->used;
+        }
+};
+
+} // namespace cen
+
+#endif // CENGINE_COLLISION_PAIR_TABLE_H
@@ -3,7 +3,13 @@
 
 #include <memory>
 #include <mutex>
+#include <atomic>
 #include <map>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
 #include <raylib.h>
 #include <raymath.h>
 
@@ -48,27 +54,143 @@ public:
         return instance;
     }
 
-    // Method to get the next ID
-    uint64_t getNextId() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return ++counter_;
+    // Method to get the next ID, lock free
+    // (parentTypeId is address of parent class _tid, it's read lazily
+    // because static initialization order between files is unspecified)
+    uint64_t getNextId(const type_id_t* parentTypeId = nullptr) {
+        auto typeId = counter_.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+        if (typeId > maxTypes) {
+            throw std::runtime_error("Too many types");
+        }
+
+        parents_[typeId - 1].store(parentTypeId, std::memory_order_release);
+        ancestryBuilt_.store(false, std::memory_order_release);
+        return typeId;
     }
 
     uint64_t typeZero() {
         return 0;
     }
 
+    // Parent type id or typeZero for root types
+    type_id_t parentOf(type_id_t typeId) const {
+        if (typeId == 0 || typeId > counter_.load(std::memory_order_acquire) || typeId > maxTypes) {
+            return 0;
+        }
+
+        auto parentTypeId = parents_[typeId - 1].load(std::memory_order_acquire);
+        return parentTypeId == nullptr ? 0 : *parentTypeId;
+    }
+
+    // Is typeId same as baseTypeId or derived from it
+    bool isA(type_id_t typeId, type_id_t baseTypeId) {
+        if (typeId == baseTypeId) {
+            return typeId != 0;
+        }
+
+        if (!ancestryBuilt_.load(std::memory_order_acquire)) {
+            buildAncestry();
+        }
+
+        if (typeId == 0 || baseTypeId == 0 || typeId > ancestryTypes_ || baseTypeId > ancestryTypes_) {
+            return false;
+        }
+
+        auto bit = baseTypeId - 1;
+        return (ancestry_[(typeId - 1) * ancestryWords_ + bit / 64] >> (bit % 64)) & 1;
+    }
+
 private:
     TypeIdGenerator() : counter_(0) {}
 
-    type_id_t counter_;
+    // Ancestry bitmask of every type (bit per type id), built on first isA
+    // call because parents are known only after static initialization
+    // (mutex is taken only while building)
+    void buildAncestry() {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (ancestryBuilt_.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        ancestryTypes_ = std::min<type_id_t>(counter_.load(std::memory_order_acquire), maxTypes);
+        ancestryWords_ = (ancestryTypes_ + 63) / 64;
+        ancestry_.assign(ancestryTypes_ * ancestryWords_, 0);
+
+        for (type_id_t typeId = 1; typeId <= ancestryTypes_; typeId++) {
+            auto row = (typeId - 1) * ancestryWords_;
+
+            for (auto ancestor = typeId; ancestor != 0; ancestor = parentOf(ancestor)) {
+                auto bit = ancestor - 1;
+                ancestry_[row + bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+        }
+
+        ancestryBuilt_.store(true, std::memory_order_release);
+    }
+
+    static constexpr type_id_t maxTypes = 1024;
+
+    std::atomic<type_id_t> counter_;
+    std::array<std::atomic<const type_id_t*>, maxTypes> parents_{};
     std::mutex mutex_;
+
+    std::atomic<bool> ancestryBuilt_ = false;
+    type_id_t ancestryTypes_ = 0;
+    type_id_t ancestryWords_ = 0;
+    std::vector<uint64_t> ancestry_;
+};
+
+// # Class that declares TypeId() used by T (T itself or its closest base declaring it)
+template <typename M>
+struct TypeIdMemberClass;
+
+template <typename C>
+struct TypeIdMemberClass<type_id_t (C::*)() const> {
+    using type = C;
 };
 
+template <typename T>
+using TypeIdOwner = typename TypeIdMemberClass<decltype(&T::TypeId)>::type;
+
+// # T overrides TypeId() with its own _tid, otherwise T::_tid is id of a base
+// (game subclasses usually don't declare one)
+template <typename T>
+constexpr bool HasOwnTypeId = std::is_same_v<TypeIdOwner<T>, T>;
+
 class WithType {
     public:
         static const type_id_t _tid;
         virtual type_id_t TypeId() const = 0;
+
+        // # Replacement for dynamic_cast, types without own _tid fall back to it
+        template <typename T>
+        bool IsA() const {
+            if constexpr (HasOwnTypeId<T>) {
+                return TypeIdGenerator::getInstance().isA(this->TypeId(), T::_tid);
+            } else {
+                return dynamic_cast<const T*>(this) != nullptr;
+            }
+        }
+
+        template <typename T>
+        T* As() {
+            if constexpr (HasOwnTypeId<T>) {
+                return this->IsA<T>() ? static_cast<T*>(this) : nullptr;
+            } else {
+                return dynamic_cast<T*>(this);
+            }
+        }
+
+        template <typename T>
+        const T* As() const {
+            if constexpr (HasOwnTypeId<T>) {
+                return this->IsA<T>() ? static_cast<const T*>(this) : nullptr;
+            } else {
+                return dynamic_cast<const T*>(this);
+            }
+        }
 };
 
 // # For future
@@ -0,0 +1,75 @@
+#ifndef CENGINE_GRID_CELLS_H
+#define CENGINE_GRID_CELLS_H
+
+#include <algorithm>
+#include <cmath>
+#include "broadphase.h"
+
+namespace cen {
+
+// # Grid cells
+// Uniform grid stored as cell entries sorted by cell key (shared by SpatialHashGrid
+// and StaticGrid). Proxy is inserted in every cell its bounds touch.
+
+struct GridCellEntry {
+    uint64_t key;
+    uint32_t proxy;
+
+    bool operator<(const GridCellEntry& other) const {
+        return this->key < other.key || (this->key == other.key && this->proxy < other.proxy);
+    }
+};
+
+inline int32_t GridCell(float coordinate, float cellSize) {
+    return static_cast<int32_t>(std::floor(coordinate / cellSize));
+}
+
+inline uint64_t GridCellKey(int32_t x, int32_t y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+// # Cell holding the corner of overlap of a and b, pair sharing several cells is
+// reported only in this one, so it is not duplicated
+inline uint64_t GridOverlapOwnerKey(const AABB& a, const AABB& b, float cellSize) {
+    return GridCellKey(
+        GridCell(std::max(a.min.x, b.min.x), cellSize),
+        GridCell(std::max(a.min.y, b.min.y), cellSize)
+    );
+}
+
+// # Calls callback(key) for every cell bounds touch
+template <typename F>
+inline void GridForEachCell(const AABB& bounds, float cellSize, F&& callback) {
+    auto minX = GridCell(bounds.min.x, cellSize);
+    auto minY = GridCell(bounds.min.y, cellSize);
+    auto maxX = GridCell(bounds.max.x, cellSize);
+    auto maxY = GridCell(bounds.max.y, cellSize);
+
+    for (auto x = minX; x <= maxX; x++) {
+        for (auto y = minY; y <= maxY; y++) {
+            callback(GridCellKey(x, y));
+        }
+    }
+}
+
+inline void GridInsert(std::vector<GridCellEntry>& entries, const AABB& bounds, uint32_t proxy, float cellSize) {
+    GridForEachCell(bounds, cellSize, [&](uint64_t key) {
+        entries.push_back({ key, proxy });
+    });
+}
+
+// # Calls callback(key, proxy) for every entry in cells bounds touch (entries must be sorted)
+template <typename F>
+inline void GridQuery(const std::vector<GridCellEntry>& entries, const AABB& bounds, float cellSize, F&& callback) {
+    GridForEachCell(bounds, cellSize, [&](uint64_t key) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), GridCellEntry{ key, 0 });
+
+        for (; it != entries.end() && it->key == key; it++) {
+            callback(key, it->proxy);
+        }
+    });
+}
+
+} // namespace cen
+
+#endif // CENGINE_GRID_CELLS_H
@@ -3,6 +3,8 @@
 
 namespace cen {
 
+const uint64_t Btn::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node2D::_tid);
+
 Btn::Btn(
     const char* btnText,
     int btnTextFontSize,
@@ -35,6 +35,12 @@ struct Callbacks {
 
 class Btn: public cen::Node2D {
     public:
+        static const uint64_t _tid;
+
+        cen::type_id_t TypeId() const override {
+            return Btn::_tid;
+        }
+
         BtnState state = BtnState::Normal;
         const char* text;
         int fontSize;
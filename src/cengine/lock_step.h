@@ -383,14 +383,19 @@ class LockStepScene: public Scene {
                 }
 
                 // # Initial
-                for (const auto& node: this->nodeStorage->rootNodes) {
-                    node->TraverseUpdate();
-                }
+                this->nodeStorage->TraverseActivated([](Node* node) {
+                    node->Update();
+                });
 
                 // # Flush events
                 this->eventBus.Flush();
 
+                // # Destroy removed nodes
+                this->nodeStorage->FlushRemovals();
+
                 // # Sync GameState and RendererState
+                this->nodeStorage->UpdateGlobalTransforms();
+
                 auto alpha = static_cast<double>(accumulatedFixedFrame) / fixedTickEveryFrameTicks;
 
                 this->renderingEngine->SyncRenderBuffer(
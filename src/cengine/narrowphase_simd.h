@@ -0,0 +1,229 @@
+#ifndef CENGINE_NARROWPHASE_SIMD_H
+#define CENGINE_NARROWPHASE_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CENGINE_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CENGINE_SIMD_SSE2
+#endif
+
+namespace cen {
+
+// # SIMD narrowphase kernels
+// Work on structure of arrays, every lane does exactly the same float
+// operations in the same order as scalar collision functions (no FMA,
+// min / max operands ordered like std::clamp / std::min), so results are
+// bit-compatible. Kernels process only whole lanes and return count of
+// processed pairs, the rest is left for scalar functions.
+
+struct CircleCircleBatch {
+    const float* positionAX;
+    const float* positionAY;
+    const float* radiusA;
+    const float* positionBX;
+    const float* positionBY;
+    const float* radiusB;
+};
+
+struct CircleRectangleBatch {
+    const float* circleX;
+    const float* circleY;
+    const float* radius;
+    const float* rectX;
+    const float* rectY;
+    const float* rectWidth;
+    const float* rectHeight;
+};
+
+struct RectangleRectangleBatch {
+    const float* positionAX;
+    const float* positionAY;
+    const float* widthA;
+    const float* heightA;
+    const float* positionBX;
+    const float* positionBY;
+    const float* widthB;
+    const float* heightB;
+};
+
+struct NarrowphaseResults {
+    float* penetration;
+    float* normalX;
+    float* normalY;
+};
+
+namespace simd {
+
+#if defined(CENGINE_SIMD_AVX2)
+
+constexpr size_t Width = 8;
+typedef __m256 Float;
+
+inline Float Load(const float* p) { return _mm256_loadu_ps(p); }
+inline void Store(float* p, Float v) { _mm256_storeu_ps(p, v); }
+inline Float Set(float v) { return _mm256_set1_ps(v); }
+inline Float Zero() { return _mm256_setzero_ps(); }
+inline Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+inline Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+inline Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+inline Float Div(Float a, Float b) { return _mm256_div_ps(a, b); }
+inline Float Sqrt(Float a) { return _mm256_sqrt_ps(a); }
+// ## a > b ? a : b
+inline Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+// ## a < b ? a : b
+inline Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+inline Float Abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+inline Float Less(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline Float Greater(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+
+#elif defined(CENGINE_SIMD_SSE2)
+
+constexpr size_t Width = 4;
+typedef __m128 Float;
+
+inline Float Load(const float* p) { return _mm_loadu_ps(p); }
+inline void Store(float* p, Float v) { _mm_storeu_ps(p, v); }
+inline Float Set(float v) { return _mm_set1_ps(v); }
+inline Float Zero() { return _mm_setzero_ps(); }
+inline Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+inline Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+inline Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+inline Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+inline Float Sqrt(Float a) { return _mm_sqrt_ps(a); }
+// ## a > b ? a : b
+inline Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+// ## a < b ? a : b
+inline Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+inline Float Abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline Float Less(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+inline Float Greater(Float a, Float b) { return _mm_cmpgt_ps(a, b); }
+inline Float And(Float a, Float b) { return _mm_and_ps(a, b); }
+
+#endif
+
+#if defined(CENGINE_SIMD_AVX2) || defined(CENGINE_SIMD_SSE2)
+
+// # Same as Vector2Normalize for lanes in mask, +0 for the rest
+inline void NormalizeMasked(Float x, Float y, Float mask, Float& normalX, Float& normalY) {
+    auto length = Sqrt(Add(Mul(x, x), Mul(y, y)));
+    auto inverseLength = Div(Set(1.0f), length);
+    auto valid = And(mask, Greater(length, Zero()));
+
+    normalX = And(valid, Mul(x, inverseLength));
+    normalY = And(valid, Mul(y, inverseLength));
+}
+
+inline void StoreResults(const NarrowphaseResults& results, size_t i, Float hit, Float penetration, Float normalX, Float normalY) {
+    Store(results.penetration + i, And(hit, penetration));
+    Store(results.normalX + i, normalX);
+    Store(results.normalY + i, normalY);
+}
+
+#endif
+
+} // namespace simd
+
+// # Same as CircleCircleCollision
+inline size_t CircleCircleKernel(const CircleCircleBatch& batch, const NarrowphaseResults& results, size_t count) {
+    size_t i = 0;
+
+#if defined(CENGINE_SIMD_AVX2) || defined(CENGINE_SIMD_SSE2)
+    using namespace simd;
+
+    for (; i + Width <= count; i += Width) {
+        auto distanceX = Sub(Load(batch.positionAX + i), Load(batch.positionBX + i));
+        auto distanceY = Sub(Load(batch.positionAY + i), Load(batch.positionBY + i));
+        auto distanceLength = Sqrt(Add(Mul(distanceX, distanceX), Mul(distanceY, distanceY)));
+        auto radiusSum = Add(Load(batch.radiusA + i), Load(batch.radiusB + i));
+
+        auto hit = Less(distanceLength, radiusSum);
+        Float normalX, normalY;
+        NormalizeMasked(distanceX, distanceY, hit, normalX, normalY);
+
+        StoreResults(results, i, hit, Sub(radiusSum, distanceLength), normalX, normalY);
+    }
+#endif
+
+    return i;
+}
+
+// # Same as CircleRectangleCollision
+inline size_t CircleRectangleKernel(const CircleRectangleBatch& batch, const NarrowphaseResults& results, size_t count) {
+    size_t i = 0;
+
+#if defined(CENGINE_SIMD_AVX2) || defined(CENGINE_SIMD_SSE2)
+    using namespace simd;
+
+    auto two = Set(2.0f);
+
+    for (; i + Width <= count; i += Width) {
+        auto circleX = Load(batch.circleX + i);
+        auto circleY = Load(batch.circleY + i);
+        auto rectX = Load(batch.rectX + i);
+        auto rectY = Load(batch.rectY + i);
+        auto halfWidth = Div(Load(batch.rectWidth + i), two);
+        auto halfHeight = Div(Load(batch.rectHeight + i), two);
+
+        // ## std::clamp(v, lo, hi) is min(hi, max(lo, v))
+        auto closestX = Min(Add(rectX, halfWidth), Max(Sub(rectX, halfWidth), circleX));
+        auto closestY = Min(Add(rectY, halfHeight), Max(Sub(rectY, halfHeight), circleY));
+
+        auto distanceX = Sub(circleX, closestX);
+        auto distanceY = Sub(circleY, closestY);
+        auto distanceLength = Sqrt(Add(Mul(distanceX, distanceX), Mul(distanceY, distanceY)));
+        auto radius = Load(batch.radius + i);
+
+        auto hit = Less(distanceLength, radius);
+        Float normalX, normalY;
+        NormalizeMasked(distanceX, distanceY, hit, normalX, normalY);
+
+        StoreResults(results, i, hit, Sub(radius, distanceLength), normalX, normalY);
+    }
+#endif
+
+    return i;
+}
+
+// # Same as RectangleRectangleCollision
+inline size_t RectangleRectangleKernel(const RectangleRectangleBatch& batch, const NarrowphaseResults& results, size_t count) {
+    size_t i = 0;
+
+#if defined(CENGINE_SIMD_AVX2) || defined(CENGINE_SIMD_SSE2)
+    using namespace simd;
+
+    auto two = Set(2.0f);
+
+    for (; i + Width <= count; i += Width) {
+        auto distanceX = Sub(Load(batch.positionAX + i), Load(batch.positionBX + i));
+        auto distanceY = Sub(Load(batch.positionAY + i), Load(batch.positionBY + i));
+
+        auto overlapX = Sub(
+            Add(Div(Load(batch.widthA + i), two), Div(Load(batch.widthB + i), two)),
+            Abs(distanceX)
+        );
+        auto overlapY = Sub(
+            Add(Div(Load(batch.heightA + i), two), Div(Load(batch.heightB + i), two)),
+            Abs(distanceY)
+        );
+
+        auto hit = And(Greater(overlapX, Zero()), Greater(overlapY, Zero()));
+        Float normalX, normalY;
+        NormalizeMasked(distanceX, distanceY, hit, normalX, normalY);
+
+        // ## std::min(x, y) is y < x ? y : x
+        StoreResults(results, i, hit, Min(overlapY, overlapX), normalX, normalY);
+    }
+#endif
+
+    return i;
+}
+
+} // namespace cen
+
+#endif // CENGINE_NARROWPHASE_SIMD_H
@@ -4,41 +4,28 @@
 #include <vector>
 #include <iostream>
 #include "core.h"
+#include "node_pool.h"
+#include "node_id_generator.h"
 
 namespace cen {
 
 class Scene;
 
-class NodeIdGenerator {
-public:
-    NodeIdGenerator(const NodeIdGenerator&) = delete;
-    NodeIdGenerator& operator=(const NodeIdGenerator&) = delete;
-
-    static NodeIdGenerator& GetInstance() {
-        static NodeIdGenerator instance;
-        return instance;
-    }
-
-    // Method to get the next ID
-    node_id_t GetNextId() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return ++counter_;
-    }
+// # Node
 
-    node_id_t typeZero() {
-        return 0;
-    }
+class NodeStorage;
+class Node;
 
-private:
-    NodeIdGenerator() : counter_(0) {}
+// # Destroys node and gives memory back to pool it came from
+// (pool nullptr means node was allocated with new)
+struct NodeDeleter {
+    NodePool* pool = nullptr;
 
-    node_id_t counter_;
-    std::mutex mutex_;
+    void operator()(Node* node) const;
 };
 
-// # Node
-
-class NodeStorage;
+template <typename T>
+using node_ptr = std::unique_ptr<T, NodeDeleter>;
 
 class Node: public cen::WithType {
     public:
@@ -46,9 +33,12 @@ class Node: public cen::WithType {
         NodeStorage* storage;
         Node* parent;
         Scene* scene;
-        std::vector<std::unique_ptr<Node>> children;
+        std::vector<node_ptr<Node>> children;
         node_id_t id;
         bool activated = true;
+        // # Position in parent children (or NodeStorage rootNodes)
+        uint32_t siblingIndex = 0;
+        bool pendingRemoval = false;
 
         static const uint64_t _tid;
 
@@ -60,7 +50,10 @@ class Node: public cen::WithType {
             node_id_t id = 0,
             Node* parent = nullptr
         ) {
+            this->id = id;
             this->parent = parent;
+            this->storage = nullptr;
+            this->scene = nullptr;
         }
 
         virtual ~Node() {}
@@ -97,50 +90,50 @@ class Node: public cen::WithType {
         T* AddNode(std::unique_ptr<T> node);
 
         // # implementations in node_node_storage.h
+        template <typename T>
+        T* AddNode(node_ptr<T> node);
+
+        // # Node constructed in storage pool
+        // implementations in node_node_storage.h
+        template <typename T, typename... Args>
+        T* AddNode(Args&&... args);
+
+        // # Removal is deferred till NodeStorage::FlushRemovals
+        // implementations in node_node_storage.h
         void RemoveChild(Node* node);
         
         // # implementations in node_node_storage.h
         void RemoveChildById(node_id_t id);
 
-        Node* GetById(node_id_t targetId) {
-            if (this->id == targetId) {
-                return this;
-            }
-
-            for (const auto& node: this->children) {
-                auto nestedFound = node->GetById(targetId);
-                if (nestedFound != nullptr) {
-                    return nestedFound;
-                }
-            }
+        // # implementations in node_node_storage.h
+        void QueueRemove();
 
-            return nullptr;
-        }
+        // # implementations in node_node_storage.h
+        Node* GetById(node_id_t targetId);
 
         template <typename T>
         T* GetById(node_id_t targetId) {
             static_assert(std::is_base_of<Node, T>::value, "T must inherit from Node");
 
-            if (auto nPtr = dynamic_cast<T*>(this)) {
-                if (nPtr->id == targetId) {
-                    return nPtr;
-                }
-            }
+            auto node = this->GetById(targetId);
 
-            for (const auto& node: this->children) {
-                auto nestedFound = node->GetById<T>(targetId);
-                if (nestedFound != nullptr) {
-                    return nestedFound;
+            return node == nullptr ? nullptr : node->As<T>();
+        }
+
+        bool IsAncestorOf(const Node* node) const {
+            for (auto current = node; current != nullptr; current = current->parent) {
+                if (current == this) {
+                    return true;
                 }
             }
 
-            return nullptr;
+            return false;
         }
 
         template <typename T>
         void GetChildByType(std::vector<T*>& nodes) {
             for (const auto& node: this->children) {
-                if (T* targetType = dynamic_cast<T*>(node.get())) {
+                if (T* targetType = node->As<T>()) {
                     nodes.push_back(targetType);
                 }
             }
@@ -149,7 +142,7 @@ class Node: public cen::WithType {
         template <typename T>
         void GetChildByTypeDeep(std::vector<T*>& targetNodes) {
             for (const auto& childNode: this->children) {
-                if (T* targetType = dynamic_cast<T*>(childNode.get())) {
+                if (T* targetType = childNode->As<T>()) {
                     targetNodes.push_back(targetType);
                 }
                 childNode->GetChildByTypeDeep<T>(targetNodes);
@@ -159,7 +152,7 @@ class Node: public cen::WithType {
         template <typename T>
         T* GetFirstChildByType() {
             for (const auto& node: this->children) {
-                if (auto targetNode = dynamic_cast<T*>(node.get())) {
+                if (auto targetNode = node->As<T>()) {
                     return targetNode;
                 }
             }
@@ -169,7 +162,7 @@ class Node: public cen::WithType {
 
         template <typename T>
         T* GetFirstByType() {
-            if (auto targetNode = dynamic_cast<T*>(this)) {
+            if (auto targetNode = this->As<T>()) {
                 return targetNode;
             }
 
@@ -190,8 +183,9 @@ class Node: public cen::WithType {
                 this->isInitialized = true;
             }
 
-            for (const auto& node: this->children) {
-                node->TraverseInit();
+            // # Index based, children can be added during traversal
+            for (size_t i = 0; i < this->children.size(); i++) {
+                this->children[i]->TraverseInit();
             }
         }
 
@@ -201,8 +195,8 @@ class Node: public cen::WithType {
             }
 
             this->Update();
-            for (const auto& node: this->children) {
-                node->TraverseUpdate();
+            for (size_t i = 0; i < this->children.size(); i++) {
+                this->children[i]->TraverseUpdate();
             }
         };
 
@@ -212,8 +206,8 @@ class Node: public cen::WithType {
             }
 
             this->FixedUpdate();
-            for (const auto& node: this->children) {
-                node->TraverseFixedUpdate();
+            for (size_t i = 0; i < this->children.size(); i++) {
+                this->children[i]->TraverseFixedUpdate();
             }
         };
 
@@ -223,12 +217,22 @@ class Node: public cen::WithType {
             }
 
             this->InvalidatePrevious();
-            for (const auto& node: this->children) {
-                node->TraverseInvalidatePrevious();
+            for (size_t i = 0; i < this->children.size(); i++) {
+                this->children[i]->TraverseInvalidatePrevious();
             }
         }
 };
 
+inline void NodeDeleter::operator()(Node* node) const {
+    if (this->pool == nullptr) {
+        delete node;
+        return;
+    }
+
+    node->~Node();
+    this->pool->Free(node);
+}
+
 } // namespace cen
 
 #endif // CENGINE_NODE_H_
\ No newline at end of file
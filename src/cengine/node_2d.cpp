@@ -1,7 +1,14 @@
 #include "node_2d.h"
+#include "node_storage.h"
 
 namespace cen {
 
-const cen::type_id_t Node2D::_tid = cen::TypeIdGenerator::getInstance().getNextId();
+const cen::type_id_t Node2D::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node::_tid);
+
+void Node2D::RecordTransformChange() {
+    if (this->storage != nullptr) {
+        this->storage->RecordTransformChange(this);
+    }
+}
 
 } // namespace cen
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define CENGINE_NODES_H
 
 #include "node.h"
+#include "transform_2d.h"
 
 namespace cen {
 
@@ -9,8 +10,22 @@ class Node2D: public Node {
     public:
         Vector2 previousPosition;
         Vector2 position;
+        // # Radians
+        float rotation = 0;
+        Vector2 scale = Vector2{ 1, 1 };
         int zOrder = 0;
 
+        // # Cache, descendants of dirty node are always dirty too
+        Transform2D globalTransform;
+        Vector2 previousGlobalPosition;
+        bool transformDirty = true;
+        // ## Local transform used for globalTransform (to notice direct writes)
+        Vector2 cachedPosition;
+        float cachedRotation = 0;
+        Vector2 cachedScale = Vector2{ 1, 1 };
+        // ## NodeStorage::transformChangesEpoch in which node was last recorded as changed
+        uint64_t transformChangesEpoch = 0;
+
         static const uint64_t _tid;
 
         cen::type_id_t TypeId() const override {
@@ -21,6 +36,11 @@ class Node2D: public Node {
             this->position = position;
             this->previousPosition = position;
             this->zOrder = zOrder;
+            this->globalTransform = Transform2DFrom(position, 0, Vector2{ 1, 1 });
+            // ## Parent isn't known yet, NodeStorage resets it from global position
+            // when node is added and after its Init
+            this->previousGlobalPosition = position;
+            this->cachedPosition = position;
         }
 
         virtual ~Node2D() {};
@@ -31,7 +51,7 @@ class Node2D: public Node {
                 return nullptr;
             }
 
-            auto n2dParent = dynamic_cast<Node2D*>(currentParent);
+            auto n2dParent = currentParent->As<Node2D>();
             if (n2dParent == nullptr) {
                 if (currentParent->parent == nullptr) {
                     return nullptr;
@@ -43,24 +63,87 @@ class Node2D: public Node {
             return n2dParent;
         }
 
-        Vector2 GlobalPosition() {
-            auto parent = this->ClosestNode2DParent();
-
-            if (parent == nullptr) {
-                return this->position;
+        // # Marks cached global transform of node and its Node2D descendants as stale
+        void MarkTransformDirty() {
+            if (this->transformDirty) {
+                return;
             }
 
-            return Vector2Add(parent->GlobalPosition(), this->position);
+            this->RecordTransformChange();
+            this->transformDirty = true;
+            MarkDescendantsTransformDirty(this);
         }
 
-        Vector2 PreviousGlobalPosition() {
-            auto parent = this->ClosestNode2DParent();
+        void SetPosition(Vector2 position) {
+            this->position = position;
+            this->MarkTransformDirty();
+        }
+
+        void Translate(Vector2 offset) {
+            this->position.x += offset.x;
+            this->position.y += offset.y;
+            this->MarkTransformDirty();
+        }
+
+        void SetRotation(float rotation) {
+            this->rotation = rotation;
+            this->MarkTransformDirty();
+        }
 
-            if (parent == nullptr) {
-                return this->previousPosition;
+        void Rotate(float angle) {
+            this->rotation += angle;
+            this->MarkTransformDirty();
+        }
+
+        void SetScale(Vector2 scale) {
+            this->scale = scale;
+            this->MarkTransformDirty();
+        }
+
+        Transform2D LocalTransform() const {
+            return Transform2DFrom(this->position, this->rotation, this->scale);
+        }
+
+        // # Cached, recomputed only after transform of node or any parent changed
+        const Transform2D& GlobalTransform() {
+            // ## Local transform written directly (without setters), direct writes of
+            // parents reach node in NodeStorage::UpdateGlobalTransforms
+            if (this->LocalTransformChanged()) {
+                this->MarkTransformDirty();
             }
 
-            return Vector2Add(parent->PreviousGlobalPosition(), this->previousPosition);
+            if (!this->transformDirty) {
+                return this->globalTransform;
+            }
+
+            auto parent = this->ClosestNode2DParent();
+
+            this->globalTransform = parent == nullptr
+                ? this->LocalTransform()
+                : Transform2DMultiply(parent->GlobalTransform(), this->LocalTransform());
+            this->cachedPosition = this->position;
+            this->cachedRotation = this->rotation;
+            this->cachedScale = this->scale;
+            this->transformDirty = false;
+
+            return this->globalTransform;
+        }
+
+        Vector2 GlobalPosition() {
+            return Transform2DOrigin(this->GlobalTransform());
+        }
+
+        float GlobalRotation() {
+            return Transform2DRotation(this->GlobalTransform());
+        }
+
+        Vector2 GlobalScale() {
+            return Transform2DScale(this->GlobalTransform());
+        }
+
+        // # Global position at the start of fixed tick (set in InvalidatePrevious)
+        Vector2 PreviousGlobalPosition() {
+            return this->previousGlobalPosition;
         }
 
         Node2D* RootNode2D() {
@@ -73,11 +156,42 @@ class Node2D: public Node {
             return p->RootNode2D();
         }
 
-        void InvalidatePrevious() override {
+        // # Interpolation starts from where node is now
+        void ResetPrevious() {
             this->previousPosition = this->position;
+            this->previousGlobalPosition = this->GlobalPosition();
+        }
+
+        void InvalidatePrevious() override {
+            this->ResetPrevious();
+        }
+
+    private:
+        // # Adds node to NodeStorage transform changes (implementation in node_2d.cpp)
+        void RecordTransformChange();
+
+        bool LocalTransformChanged() const {
+            return this->position.x != this->cachedPosition.x ||
+                this->position.y != this->cachedPosition.y ||
+                this->rotation != this->cachedRotation ||
+                this->scale.x != this->cachedScale.x ||
+                this->scale.y != this->cachedScale.y;
+        }
+
+        static void MarkDescendantsTransformDirty(Node* node) {
+            for (const auto& child: node->children) {
+                // ## Non Node2D nodes are passed through
+                auto child2D = child->As<Node2D>();
+                if (child2D == nullptr) {
+                    MarkDescendantsTransformDirty(child.get());
+                    continue;
+                }
+
+                child2D->MarkTransformDirty();
+            }
         }
 };
 
 } // namespace cen
 
-#endif // CENGINE_NODES_H
\ No newline at end of file
+#endif // CENGINE_NODES_H
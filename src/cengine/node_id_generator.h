@@ -0,0 +1,233 @@
+#ifndef CENGINE_NODE_ID_GENERATOR_H_
+#define CENGINE_NODE_ID_GENERATOR_H_
+
+#include <array>
+#include <atomic>
+#include <stdexcept>
+#include "core.h"
+
+namespace cen {
+
+// # Node Id
+// Node ids are generational handles:
+// upper 32 bits are slot generation, lower 32 bits are slot index
+
+inline node_id_t MakeNodeId(uint32_t index, uint32_t generation) {
+    return (static_cast<node_id_t>(generation) << 32) | index;
+}
+
+inline uint32_t NodeIdIndex(node_id_t id) {
+    return static_cast<uint32_t>(id & 0xFFFFFFFF);
+}
+
+inline uint32_t NodeIdGeneration(node_id_t id) {
+    return static_cast<uint32_t>(id >> 32);
+}
+
+// # Wire id
+// 32 bit id for packets: low 8 bits of generation and 24 bit index
+
+typedef uint32_t wire_node_id_t;
+
+constexpr uint32_t WireNodeIdIndexBits = 24;
+
+inline wire_node_id_t NodeIdToWire(node_id_t id) {
+    return ((NodeIdGeneration(id) & 0xFF) << WireNodeIdIndexBits) | NodeIdIndex(id);
+}
+
+inline uint32_t WireNodeIdIndex(wire_node_id_t wireId) {
+    return wireId & ((1u << WireNodeIdIndexBits) - 1);
+}
+
+inline uint32_t WireNodeIdGeneration(wire_node_id_t wireId) {
+    return wireId >> WireNodeIdIndexBits;
+}
+
+// # Block of fresh ids reserved by one thread, used without atomics
+struct NodeIdBlock {
+    uint32_t next = 0;
+    uint32_t end = 0;
+};
+
+// # Node Id Generator
+// Lock free, safe to use from several threads. Released ids go to graveyard
+// (Treiber stack) and are reused with next generation, so stale ids never resolve.
+// Index is limited to 24 bits, so every id fits wire id.
+
+class NodeIdGenerator {
+    private:
+        static constexpr uint32_t PageBits = 12;
+        static constexpr uint32_t PageSize = 1u << PageBits;
+        static constexpr uint32_t PagesCount = (1u << WireNodeIdIndexBits) / PageSize;
+
+        struct Entry {
+            std::atomic<uint32_t> generation;
+            // ## Id was handed out by Acquire and not released since
+            std::atomic<bool> acquired;
+            // ## Graveyard link, index + 1 (0 is end)
+            std::atomic<uint32_t> nextFree;
+        };
+
+        // # Pages are allocated on first use and never moved, so entries can be read without lock
+        std::array<std::atomic<Entry*>, PagesCount> pages{};
+        std::atomic<uint32_t> nextIndex = 0;
+        // # Graveyard head: upper 32 bits are ABA tag, lower 32 bits are index + 1 (0 is empty)
+        std::atomic<uint64_t> graveyard = 0;
+
+        Entry& EntryAt(uint32_t index) {
+            auto& page = this->pages[index >> PageBits];
+            auto entries = page.load(std::memory_order_acquire);
+
+            if (entries == nullptr) {
+                auto newEntries = new Entry[PageSize];
+                for (uint32_t i = 0; i < PageSize; i++) {
+                    // ## Generation 0 is never used, so id 0 stays invalid
+                    newEntries[i].generation.store(1, std::memory_order_relaxed);
+                    newEntries[i].acquired.store(false, std::memory_order_relaxed);
+                    newEntries[i].nextFree.store(0, std::memory_order_relaxed);
+                }
+
+                // ## Other thread could allocate page first
+                if (page.compare_exchange_strong(entries, newEntries, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    entries = newEntries;
+                } else {
+                    delete[] newEntries;
+                }
+            }
+
+            return entries[index & (PageSize - 1)];
+        }
+
+        const Entry* FindEntry(uint32_t index) const {
+            // ## Ids are read from packets, so index can be anything
+            if (index >= this->nextIndex.load(std::memory_order_acquire) || (index >> PageBits) >= PagesCount) {
+                return nullptr;
+            }
+
+            auto entries = this->pages[index >> PageBits].load(std::memory_order_acquire);
+            if (entries == nullptr) {
+                return nullptr;
+            }
+
+            return &entries[index & (PageSize - 1)];
+        }
+
+        // # nextIndex is advanced only when all indexes fit, so failed reservation
+        // doesn't leave it past allocated pages
+        uint32_t ReserveIndexes(uint32_t count) {
+            auto index = this->nextIndex.load(std::memory_order_acquire);
+
+            do {
+                if (static_cast<uint64_t>(index) + count > (1u << WireNodeIdIndexBits)) {
+                    throw std::runtime_error("Node ids exhausted");
+                }
+            } while (!this->nextIndex.compare_exchange_weak(index, index + count, std::memory_order_acq_rel, std::memory_order_acquire));
+
+            return index;
+        }
+
+        // # Marks index acquired and returns its current id
+        node_id_t Hand(uint32_t index) {
+            auto& entry = this->EntryAt(index);
+            entry.acquired.store(true, std::memory_order_release);
+
+            return MakeNodeId(index, entry.generation.load(std::memory_order_acquire));
+        }
+
+        bool PopGraveyard(node_id_t& id) {
+            auto head = this->graveyard.load(std::memory_order_acquire);
+
+            while ((head & 0xFFFFFFFF) != 0) {
+                auto index = static_cast<uint32_t>(head & 0xFFFFFFFF) - 1;
+                auto& entry = this->EntryAt(index);
+                auto next = entry.nextFree.load(std::memory_order_relaxed);
+                auto newHead = (((head >> 32) + 1) << 32) | next;
+
+                if (this->graveyard.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    id = this->Hand(index);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+    public:
+        // # Ids taken from reserved blocks at once
+        uint32_t blockSize;
+
+        NodeIdGenerator(uint32_t blockSize = 256) {
+            this->blockSize = blockSize;
+        }
+
+        NodeIdGenerator(const NodeIdGenerator&) = delete;
+        NodeIdGenerator& operator=(const NodeIdGenerator&) = delete;
+
+        ~NodeIdGenerator() {
+            for (auto& page: this->pages) {
+                delete[] page.load(std::memory_order_relaxed);
+            }
+        }
+
+        node_id_t Acquire() {
+            node_id_t id;
+            if (this->PopGraveyard(id)) {
+                return id;
+            }
+
+            return this->Hand(this->ReserveIndexes(1));
+        }
+
+        // # For thread local blocks, fresh ids are taken without contention
+        node_id_t Acquire(NodeIdBlock& block) {
+            node_id_t id;
+            if (this->PopGraveyard(id)) {
+                return id;
+            }
+
+            if (block.next == block.end) {
+                block.next = this->ReserveIndexes(this->blockSize);
+                block.end = block.next + this->blockSize;
+            }
+
+            return this->Hand(block.next++);
+        }
+
+        // # Id must be current and released once
+        void Release(node_id_t id) {
+            auto index = NodeIdIndex(id);
+            auto& entry = this->EntryAt(index);
+
+            auto generation = NodeIdGeneration(id);
+            entry.acquired.store(false, std::memory_order_release);
+            entry.generation.store(generation == UINT32_MAX ? 1 : generation + 1, std::memory_order_release);
+
+            auto head = this->graveyard.load(std::memory_order_relaxed);
+            uint64_t newHead;
+            do {
+                entry.nextFree.store(static_cast<uint32_t>(head & 0xFFFFFFFF), std::memory_order_relaxed);
+                newHead = (((head >> 32) + 1) << 32) | (index + 1);
+            } while (!this->graveyard.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // # Id was acquired and not released since (ids waiting in graveyard and
+        // reserved indexes not handed out yet are not current)
+        bool IsCurrent(node_id_t id) const {
+            auto entry = this->FindEntry(NodeIdIndex(id));
+
+            return entry != nullptr &&
+                entry->acquired.load(std::memory_order_acquire) &&
+                entry->generation.load(std::memory_order_acquire) == NodeIdGeneration(id);
+        }
+
+        // # Current id of index or 0
+        node_id_t CurrentId(uint32_t index) const {
+            auto entry = this->FindEntry(index);
+
+            return entry == nullptr ? 0 : MakeNodeId(index, entry->generation.load(std::memory_order_acquire));
+        }
+};
+
+} // namespace cen
+
+#endif // CENGINE_NODE_ID_GENERATOR_H_
@@ -8,6 +8,20 @@ namespace cen {
 
 template <typename T>
 T* Node::AddNode(std::unique_ptr<T> newNode) {
+    return this->AddNode(node_ptr<T>(newNode.release()));
+}
+
+template <typename T, typename... Args>
+T* Node::AddNode(Args&&... args) {
+    if (this->storage == nullptr) {
+        throw std::runtime_error("Node storage is not set");
+    }
+
+    return this->AddNode(this->storage->MakeNode<T>(std::forward<Args>(args)...));
+}
+
+template <typename T>
+T* Node::AddNode(node_ptr<T> newNode) {
     static_assert(std::is_base_of<Node, T>::value, "T must inherit from Node");
     if (this->storage == nullptr) {
         throw std::runtime_error("Node storage is not set");
@@ -15,35 +29,48 @@ T* Node::AddNode(std::unique_ptr<T> newNode) {
     newNode->storage = this->storage;
     newNode->parent = this;
     newNode->scene = this->scene;
+    newNode->siblingIndex = static_cast<uint32_t>(this->children.size());
     auto nodePtr = newNode.get();
-    if (nodePtr->id == 0) {
-        nodePtr->id = NodeIdGenerator::GetInstance().GetNextId();
-    }
     this->children.push_back(std::move(newNode));
     this->storage->OnNestedNodeCreated(nodePtr);
     return nodePtr;
 }
 
 inline void Node::RemoveChild(Node* node) {
-    this->storage->RemoveFromIndex(node);
-
-    for (auto i = 0; i < this->children.size(); i++) {
-        if (this->children[i].get() == node) {
-            this->children.erase(this->children.begin() + i);
-            break;
-        }
+    if (node->parent != this) {
+        return;
     }
+
+    this->storage->QueueRemove(node);
+}
+
+inline void Node::QueueRemove() {
+    this->storage->QueueRemove(this);
 }
 
 inline void Node::RemoveChildById(node_id_t id) {
-    this->storage->RemoveFromIndexById(id);
+    auto node = this->storage->GetById(id);
 
-    for (auto i = 0; i < this->children.size(); i++) {
-        if (this->children[i]->id == id) {
-            this->children.erase(this->children.begin() + i);
-            break;
-        }
+    if (node == nullptr || node->parent != this) {
+        return;
     }
+
+    this->RemoveChild(node);
+}
+
+inline Node* Node::GetById(node_id_t targetId) {
+    // # Not added to storage yet
+    if (this->storage == nullptr) {
+        return this->id == targetId ? this : nullptr;
+    }
+
+    auto node = this->storage->GetById(targetId);
+
+    if (node == nullptr || !this->IsAncestorOf(node)) {
+        return nullptr;
+    }
+
+    return node;
 }
 
 } // namespace cen
@@ -0,0 +1,132 @@
+#ifndef CENGINE_NODE_POOL_H_
+#define CENGINE_NODE_POOL_H_
+
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <new>
+#include <cstddef>
+
+namespace cen {
+
+// # Node pool
+// Fixed size object pool, memory is taken from chunks of objectsPerChunk
+// objects and freed objects are reused through intrusive free list.
+// Chunks are released only when pool is destroyed.
+
+class NodePool {
+    private:
+        struct FreeObject {
+            FreeObject* next;
+        };
+
+        struct ChunkDeleter {
+            size_t alignment;
+
+            void operator()(std::byte* chunk) const {
+                ::operator delete(chunk, std::align_val_t(this->alignment));
+            }
+        };
+
+        std::vector<std::unique_ptr<std::byte, ChunkDeleter>> chunks;
+        FreeObject* freeList = nullptr;
+        // # Objects used in last chunk
+        size_t lastChunkUsed = 0;
+
+    public:
+        size_t objectSize;
+        size_t alignment;
+        size_t objectsPerChunk;
+
+        NodePool(
+            size_t objectSize,
+            size_t alignment,
+            size_t objectsPerChunk = 64
+        ) {
+            this->alignment = std::max(alignment, alignof(FreeObject));
+            // # Every object must be able to hold free list link and keep alignment
+            auto size = std::max(objectSize, sizeof(FreeObject));
+            this->objectSize = (size + this->alignment - 1) / this->alignment * this->alignment;
+            this->objectsPerChunk = objectsPerChunk;
+            this->lastChunkUsed = objectsPerChunk;
+        }
+
+        NodePool(const NodePool&) = delete;
+        NodePool& operator=(const NodePool&) = delete;
+
+        void* Allocate() {
+            if (this->freeList != nullptr) {
+                auto object = this->freeList;
+                this->freeList = object->next;
+                return object;
+            }
+
+            if (this->lastChunkUsed == this->objectsPerChunk) {
+                auto chunk = static_cast<std::byte*>(::operator new(
+                    this->objectSize * this->objectsPerChunk,
+                    std::align_val_t(this->alignment)
+                ));
+                this->chunks.emplace_back(chunk, ChunkDeleter{ this->alignment });
+                this->lastChunkUsed = 0;
+            }
+
+            return this->chunks.back().get() + this->objectSize * this->lastChunkUsed++;
+        }
+
+        void Free(void* object) {
+            auto freeObject = static_cast<FreeObject*>(object);
+            freeObject->next = this->freeList;
+            this->freeList = freeObject;
+        }
+
+        size_t ChunksCount() const {
+            return this->chunks.size();
+        }
+};
+
+// # Node pool allocator
+// One pool per node type, pools are indexed by per type index given on first use.
+
+class NodePoolAllocator {
+    private:
+        std::vector<std::unique_ptr<NodePool>> pools;
+
+        static size_t NextPoolIndex() {
+            static std::atomic<size_t> nextPoolIndex = 0;
+            return nextPoolIndex.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    public:
+        size_t objectsPerChunk;
+
+        NodePoolAllocator(size_t objectsPerChunk = 64) {
+            this->objectsPerChunk = objectsPerChunk;
+        }
+
+        template <typename T>
+        static size_t PoolIndex() {
+            static const size_t poolIndex = NextPoolIndex();
+            return poolIndex;
+        }
+
+        template <typename T>
+        NodePool* PoolFor() {
+            auto index = PoolIndex<T>();
+
+            if (index >= this->pools.size()) {
+                this->pools.resize(index + 1);
+            }
+
+            auto& pool = this->pools[index];
+            if (pool == nullptr) {
+                pool = std::make_unique<NodePool>(sizeof(T), alignof(T), this->objectsPerChunk);
+            }
+
+            return pool.get();
+        }
+};
+
+} // namespace cen
+
+#endif // CENGINE_NODE_POOL_H_
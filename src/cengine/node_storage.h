@@ -2,6 +2,7 @@
 #define CENGINE_STORAGE_H_
 
 #include <vector>
+#include <stdexcept>
 #include "node.h"
 #include "node_2d.h"
 
@@ -14,13 +15,243 @@ enum class NodeStorageState {
 
 class Scene;
 
+constexpr uint32_t NodeNotIndexed = UINT32_MAX;
+
+// # Slot map entry, slot index is node id index
+struct NodeSlot {
+    Node* node = nullptr;
+
+    // # Positions of node in NodeStorage indexes (for swap and pop removal)
+    uint32_t flatIndex = NodeNotIndexed;
+    uint32_t newIndex = NodeNotIndexed;
+    uint32_t renderIndex = NodeNotIndexed;
+    // # Order in which nodes were added (draw order of nodes with same zOrder)
+    uint64_t addSequence = 0;
+    // # Position in type index of every type in node type chain (own type first)
+    std::vector<uint32_t> typeIndexes;
+};
+
 class NodeStorage {
+    private:
+        // # Declared first, so pools outlive nodes they hold
+        NodePoolAllocator allocator;
+
+        std::vector<NodeSlot> slots;
+        uint64_t nextAddSequence = 0;
+
+        // # Keeps id if it was acquired from this storage for the node (see AcquireId)
+        node_id_t AllocateSlot(Node* node) {
+            auto id = node->id;
+
+            if (!this->idGenerator.IsCurrent(id) || this->IsSlotUsed(NodeIdIndex(id))) {
+                id = this->idGenerator.Acquire();
+            }
+
+            auto index = NodeIdIndex(id);
+            if (index >= this->slots.size()) {
+                this->slots.resize(index + 1);
+            }
+
+            auto& slot = this->slots[index];
+            slot.node = node;
+            slot.flatIndex = NodeNotIndexed;
+            slot.newIndex = NodeNotIndexed;
+            slot.renderIndex = NodeNotIndexed;
+            slot.addSequence = this->nextAddSequence++;
+            slot.typeIndexes.clear();
+
+            return id;
+        }
+
+        void FreeSlot(node_id_t id) {
+            auto index = NodeIdIndex(id);
+
+            if (!this->idGenerator.IsCurrent(id) || !this->IsSlotUsed(index)) {
+                return;
+            }
+
+            this->slots[index].node = nullptr;
+            this->idGenerator.Release(id);
+        }
+
+        bool IsSlotUsed(uint32_t index) const {
+            return index < this->slots.size() && this->slots[index].node != nullptr;
+        }
+
+        NodeSlot& SlotOf(const Node* node) {
+            return this->slots[NodeIdIndex(node->id)];
+        }
+
+        // # Removes element at index by moving last element in its place,
+        // returns moved element (nullptr if removed element was the last one)
+        template <typename T>
+        static T* SwapRemove(std::vector<T*>& nodes, uint32_t index) {
+            auto last = nodes.back();
+            nodes.pop_back();
+
+            if (index == nodes.size()) {
+                return nullptr;
+            }
+
+            nodes[index] = last;
+
+            return last;
+        }
+
+        // # Nodes by type id, node is indexed under its type and every parent type
+        std::vector<std::vector<Node*>> typeIndex;
+
+        void AddToTypeIndex(Node* node) {
+            const auto& typeIdGenerator = TypeIdGenerator::getInstance();
+            auto& slot = this->SlotOf(node);
+
+            for (auto typeId = node->TypeId(); typeId != 0; typeId = typeIdGenerator.parentOf(typeId)) {
+                if (typeId >= this->typeIndex.size()) {
+                    this->typeIndex.resize(typeId + 1);
+                }
+
+                slot.typeIndexes.push_back(static_cast<uint32_t>(this->typeIndex[typeId].size()));
+                this->typeIndex[typeId].push_back(node);
+            }
+        }
+
+        void RemoveFromTypeIndex(Node* node) {
+            const auto& typeIdGenerator = TypeIdGenerator::getInstance();
+            auto& slot = this->SlotOf(node);
+
+            auto chainIndex = 0;
+            for (auto typeId = node->TypeId(); typeId != 0; typeId = typeIdGenerator.parentOf(typeId)) {
+                auto index = slot.typeIndexes[chainIndex++];
+                auto moved = SwapRemove(this->typeIndex[typeId], index);
+
+                if (moved == nullptr) {
+                    continue;
+                }
+
+                // ## Find typeId in moved node type chain
+                auto& movedSlot = this->SlotOf(moved);
+                auto movedChainIndex = 0;
+                for (auto movedTypeId = moved->TypeId(); movedTypeId != typeId; movedTypeId = typeIdGenerator.parentOf(movedTypeId)) {
+                    movedChainIndex++;
+                }
+                movedSlot.typeIndexes[movedChainIndex] = index;
+            }
+
+            slot.typeIndexes.clear();
+        }
+
+        void AddToIndex(Node* node) {
+            auto& slot = this->SlotOf(node);
+
+            slot.flatIndex = static_cast<uint32_t>(this->flatNodes.size());
+            this->flatNodes.push_back(node);
+
+            if (this->state == NodeStorageState::INITIALIZED) {
+                slot.newIndex = static_cast<uint32_t>(this->newNodes.size());
+                this->newNodes.push_back(node);
+            }
+
+            if (Node2D* n2d = node->As<Node2D>()) {
+                slot.renderIndex = static_cast<uint32_t>(this->renderNodes.size());
+                this->renderNodes.push_back(n2d);
+
+                // ## Parent is known now, so node isn't interpolated from its local position
+                n2d->ResetPrevious();
+                this->RecordTransformChange(n2d);
+            }
+
+            this->AddToTypeIndex(node);
+            this->traversalOrderDirty = true;
+            this->structureVersion++;
+        }
+
+        // # Removes node and all its descendants from indexes
+        void RemoveFromIndex(Node* node) {
+            for (const auto& child: node->children) {
+                this->RemoveFromIndex(child.get());
+            }
+
+            auto& slot = this->SlotOf(node);
+
+            if (auto moved = SwapRemove(this->flatNodes, slot.flatIndex)) {
+                this->SlotOf(moved).flatIndex = slot.flatIndex;
+            }
+
+            if (slot.newIndex != NodeNotIndexed) {
+                if (auto moved = SwapRemove(this->newNodes, slot.newIndex)) {
+                    this->SlotOf(moved).newIndex = slot.newIndex;
+                }
+            }
+
+            if (slot.renderIndex != NodeNotIndexed) {
+                if (auto moved = SwapRemove(this->renderNodes, slot.renderIndex)) {
+                    this->SlotOf(moved).renderIndex = slot.renderIndex;
+                }
+            }
+
+            this->RemoveFromTypeIndex(node);
+            this->FreeSlot(node->id);
+        }
+
+        // # Unindexes and destroys node with its descendants
+        void DestroyNode(Node* node) {
+            this->RemoveFromIndex(node);
+
+            auto& owner = node->parent == nullptr ? this->rootNodes : node->parent->children;
+            auto index = node->siblingIndex;
+
+            // ## Keep node alive until owner is consistent again
+            auto removed = std::move(owner[index]);
+
+            if (index != owner.size() - 1) {
+                owner[index] = std::move(owner.back());
+                owner[index]->siblingIndex = index;
+            }
+
+            owner.pop_back();
+            this->traversalOrderDirty = true;
+            this->structureVersion++;
+        }
+
+        // # Nodes in pre-order, subtreeEnds[i] is index right after last descendant of traversalOrder[i]
+        std::vector<Node*> traversalOrder;
+        std::vector<uint32_t> subtreeEnds;
+        bool traversalOrderDirty = true;
+
+        void AppendSubtree(Node* node) {
+            auto index = this->traversalOrder.size();
+            this->traversalOrder.push_back(node);
+            this->subtreeEnds.push_back(0);
+
+            for (const auto& child: node->children) {
+                this->AppendSubtree(child.get());
+            }
+
+            this->subtreeEnds[index] = static_cast<uint32_t>(this->traversalOrder.size());
+        }
+
+        void RebuildTraversalOrder() {
+            this->traversalOrder.clear();
+            this->subtreeEnds.clear();
+
+            for (const auto& node: this->rootNodes) {
+                this->AppendSubtree(node.get());
+            }
+
+            this->traversalOrderDirty = false;
+        }
+
     public:
         Scene* scene;
-        std::vector<std::unique_ptr<Node>> rootNodes;
+        std::vector<node_ptr<Node>> rootNodes;
         std::vector<Node*> flatNodes;
         std::vector<Node*> newNodes;
         std::vector<Node2D*> renderNodes;
+        NodeIdGenerator idGenerator;
+        // # Incremented whenever node is added or destroyed
+        uint64_t structureVersion = 0;
+        // # Ids of nodes to remove on next FlushRemovals
+        std::vector<node_id_t> removalQueue;
         uint64_t nextId;
         NodeStorageState state = NodeStorageState::CREATED;
 
@@ -32,8 +263,13 @@ class NodeStorage {
             this->nextId = nextId;
         }
 
+        // # Nodes added before are initialized by now (Init could move them)
         void Init() {
             this->state = NodeStorageState::INITIALIZED;
+
+            for (auto n2d: this->renderNodes) {
+                n2d->ResetPrevious();
+            }
         }
 
         uint64_t GetNextId() {
@@ -41,131 +277,255 @@ class NodeStorage {
         }
 
         void OnNestedNodeCreated(Node* newNode) {
-            this->flatNodes.push_back(newNode);
-            if (this->state == NodeStorageState::INITIALIZED) {
-                this->newNodes.push_back(newNode);
-            }
-            if (Node2D* n2d = dynamic_cast<Node2D*>(newNode)) {
-                this->renderNodes.push_back(n2d);
-            }
+            newNode->id = this->AllocateSlot(newNode);
+            this->AddToIndex(newNode);
         }
 
         void InitNewNodes() {
+            // # Init can add new nodes, so size is checked every iteration
             for (auto i = 0; i < this->newNodes.size(); i++) {
+                this->SlotOf(this->newNodes[i]).newIndex = NodeNotIndexed;
                 this->newNodes[i]->Init();
+
+                // ## Init could move node
+                if (auto n2d = this->newNodes[i]->As<Node2D>()) {
+                    n2d->ResetPrevious();
+                }
             }
- 
+
             this->newNodes.clear();
         }
 
+        // # Constructs node in pool of its type, memory is reused after node is removed
+        // and released all at once with storage
+        template <typename T, typename... Args>
+        node_ptr<T> MakeNode(Args&&... args) {
+            static_assert(std::is_base_of<Node, T>::value, "T must inherit from Node");
+
+            auto pool = this->allocator.PoolFor<T>();
+            auto memory = pool->Allocate();
+
+            T* node;
+            try {
+                node = new (memory) T(std::forward<Args>(args)...);
+            } catch (...) {
+                pool->Free(memory);
+                throw;
+            }
+
+            // # NodeDeleter frees Node address, so it must be the allocated one
+            if (static_cast<void*>(static_cast<Node*>(node)) != memory) {
+                node->~T();
+                pool->Free(memory);
+                throw std::runtime_error("Node must be first base class to be pool allocated");
+            }
+
+            return node_ptr<T>(node, NodeDeleter{ pool });
+        }
+
+        template <typename T, typename... Args>
+        T* AddNode(Args&&... args) {
+            return this->AddNode(this->MakeNode<T>(std::forward<Args>(args)...));
+        }
+
         template <typename T>
         T* AddNode(std::unique_ptr<T> newNode) {
+            return this->AddNode(node_ptr<T>(newNode.release()));
+        }
+
+        template <typename T>
+        T* AddNode(node_ptr<T> newNode) {
             static_assert(std::is_base_of<Node, T>::value, "T must inherit from Node");
             newNode->storage = this;
             newNode->scene = this->scene;
+            newNode->siblingIndex = static_cast<uint32_t>(this->rootNodes.size());
             T* nPtr = newNode.get();
-            if (nPtr->id == 0) {
-                nPtr->id = NodeIdGenerator::GetInstance().GetNextId();
-            }
+            nPtr->id = this->AllocateSlot(nPtr);
             this->rootNodes.push_back(std::move(newNode));
-            this->flatNodes.push_back(nPtr);
-            if (this->state == NodeStorageState::INITIALIZED) {
-                this->newNodes.push_back(nPtr);
-            }
-            if (Node2D* n2d = dynamic_cast<Node2D*>(nPtr)) {
-                this->renderNodes.push_back(n2d);
-            }
+            this->AddToIndex(nPtr);
             return nPtr;
         }
 
-        void RemoveFromIndex(Node* node) {
-            for (auto i = 0; i < this->flatNodes.size(); i++) {
-                if (this->flatNodes[i] == node) {
-                    this->flatNodes.erase(this->flatNodes.begin() + i);
-                    break;
-                }
+        // # Node (with its descendants) stays alive and indexed till FlushRemovals,
+        // so it's safe to remove nodes while traversing
+        void QueueRemove(Node* node) {
+            if (node->pendingRemoval) {
+                return;
             }
 
-            for (auto i = 0; i < this->newNodes.size(); i++) {
-                if (this->newNodes[i] == node) {
-                    this->newNodes.erase(this->newNodes.begin() + i);
-                    break;
+            node->pendingRemoval = true;
+            this->removalQueue.push_back(node->id);
+        }
+
+        // # Visits activated nodes in pre-order, deactivated subtrees are skipped.
+        // Order is rebuilt only after nodes were added or destroyed, nodes added
+        // during traversal are visited from next traversal.
+        template <typename F>
+        void TraverseActivated(F&& visit) {
+            if (this->traversalOrderDirty) {
+                this->RebuildTraversalOrder();
+            }
+
+            uint32_t i = 0;
+            while (i < this->traversalOrder.size()) {
+                auto node = this->traversalOrder[i];
+
+                if (!node->activated) {
+                    i = this->subtreeEnds[i];
+                    continue;
                 }
+
+                visit(node);
+                i++;
             }
         }
 
-        void RemoveFromIndexById(node_id_t id) {
-            for (auto i = 0; i < this->flatNodes.size(); i++) {
-                if (this->flatNodes[i]->id == id) {
-                    this->flatNodes.erase(this->flatNodes.begin() + i);
-                    break;
-                }
+        // # Node2D nodes added or moved since last ClearTransformChanges, each once. Moved
+        // means cached global transform went stale (setter on node or any parent, or
+        // direct write noticed when transform was read)
+        std::vector<node_id_t> transformChanges;
+        uint64_t transformChangesEpoch = 1;
+
+        void RecordTransformChange(Node2D* node) {
+            if (node->transformChangesEpoch == this->transformChangesEpoch) {
+                return;
             }
 
-            for (auto i = 0; i < this->newNodes.size(); i++) {
-                if (this->newNodes[i]->id == id) {
-                    this->newNodes.erase(this->newNodes.begin() + i);
-                    break;
+            node->transformChangesEpoch = this->transformChangesEpoch;
+            this->transformChanges.push_back(node->id);
+        }
+
+        void ClearTransformChanges() {
+            this->transformChanges.clear();
+            this->transformChangesEpoch++;
+        }
+
+        // # Increases with every added node, stays same while node is alive
+        uint64_t AddSequenceOf(const Node* node) {
+            return this->SlotOf(node).addSequence;
+        }
+
+        // # Refreshes cached global transforms in one top-down pass (parent is refreshed
+        // before its children), also picks up local transforms written directly without setters
+        void UpdateGlobalTransforms() {
+            if (this->traversalOrderDirty) {
+                this->RebuildTraversalOrder();
+            }
+
+            for (auto node: this->traversalOrder) {
+                if (auto n2d = node->As<Node2D>()) {
+                    n2d->GlobalTransform();
                 }
             }
         }
 
-        void RemoveNode(Node* node) {
-            this->RemoveFromIndex(node);
-
-            for (auto i = 0; i < this->rootNodes.size(); i++) {
-                if (this->rootNodes[i].get() == node) {
-                    this->rootNodes.erase(this->rootNodes.begin() + i);
-                    break;
+        void FlushRemovals() {
+            // # Destructors can queue more removals, so size is checked every iteration
+            for (size_t i = 0; i < this->removalQueue.size(); i++) {
+                // ## Already destroyed with removed ancestor
+                auto node = this->GetById(this->removalQueue[i]);
+                if (node == nullptr) {
+                    continue;
                 }
+
+                this->DestroyNode(node);
             }
+
+            this->removalQueue.clear();
+        }
+
+        void RemoveNode(Node* node) {
+            this->QueueRemove(node);
         }
 
         void RemoveNodeById(node_id_t id) {
-            this->RemoveFromIndexById(id);
+            auto node = this->GetById(id);
 
-            for (auto i = 0; i < this->rootNodes.size(); i++) {
-                if (this->rootNodes[i]->id == id) {
-                    this->rootNodes.erase(this->rootNodes.begin() + i);
-                    break;
-                }
+            if (node == nullptr) {
+                return;
             }
+
+            this->RemoveNode(node);
         }
 
+        // # Constant time, returns nullptr for removed (stale) ids
         Node* GetById(node_id_t targetId) {
-            for (const auto& node: this->rootNodes) {
-                auto result = node->GetById(targetId);
-                if (result != nullptr) {
-                    return result;
-                }
+            auto index = NodeIdIndex(targetId);
+
+            if (!this->IsSlotUsed(index) || !this->idGenerator.IsCurrent(targetId)) {
+                return nullptr;
             }
 
-            return nullptr;
+            return this->slots[index].node;
+        }
+
+        // # Resolves 32 bit id received in packet
+        Node* GetByWireId(wire_node_id_t wireId) {
+            auto id = this->idGenerator.CurrentId(WireNodeIdIndex(wireId));
+
+            if (id == 0 || (NodeIdGeneration(id) & 0xFF) != WireNodeIdGeneration(wireId)) {
+                return nullptr;
+            }
+
+            return this->GetById(id);
+        }
+
+        // # Thread safe, id can be given to node (node->id) before it's added to this storage
+        node_id_t AcquireId() {
+            return this->idGenerator.Acquire();
+        }
+
+        node_id_t AcquireId(NodeIdBlock& block) {
+            return this->idGenerator.Acquire(block);
+        }
+
+        bool IsAlive(node_id_t id) {
+            return this->GetById(id) != nullptr;
         }
 
         template <typename T>
         T* GetById(node_id_t targetId) {
             static_assert(std::is_base_of<Node, T>::value, "T must inherit from Node");
 
-            for (const auto& node: this->rootNodes) {
-                auto result = node->GetById<T>(targetId);
-                if (result != nullptr) {
-                    return result;
-                }
+            auto node = this->GetById(targetId);
+
+            return node == nullptr ? nullptr : node->As<T>();
+        }
+
+        // # All nodes (root and nested) of type or derived from it
+        const std::vector<Node*>& GetAllByTypeId(type_id_t typeId) {
+            static const std::vector<Node*> empty;
+
+            if (typeId >= this->typeIndex.size()) {
+                return empty;
             }
 
-            return nullptr;
+            return this->typeIndex[typeId];
+        }
+
+        // # T must declare its own _tid (index can't tell apart subclasses without one)
+        template <typename T>
+        const std::vector<Node*>& GetAllByType() {
+            static_assert(std::is_base_of<Node, T>::value, "T must inherit from Node");
+            static_assert(HasOwnTypeId<T>, "T must declare its own _tid and TypeId()");
+
+            return this->GetAllByTypeId(T::_tid);
         }
 
         template <typename T>
         std::vector<T*> GetByType() {
             static_assert(std::is_base_of<Node, T>::value, "T must inherit from Node");
 
-            std::vector<Node*> nodes;
+            std::vector<T*> nodes;
 
-            for (const auto& node: this->rootNodes) {
-                if (T* nPtr = dynamic_cast<T*>(node.get())) {
-                    nodes.push_back(nPtr);
+            // ## Subclasses without own _tid are found in index of their base
+            for (Node* node: this->GetAllByTypeId(TypeIdOwner<T>::_tid)) {
+                if (node->parent != nullptr) {
+                    continue;
+                }
+
+                if (auto targetNode = node->As<T>()) {
+                    nodes.push_back(targetNode);
                 }
             }
 
@@ -176,9 +536,13 @@ class NodeStorage {
         T* GetFirstByType() {
             static_assert(std::is_base_of<Node, T>::value, "T must inherit from Node");
 
-            for (const auto& node: this->rootNodes) {
-                if (T* nPtr = dynamic_cast<T*>(node.get())) {
-                    return nPtr;
+            for (Node* node: this->GetAllByTypeId(TypeIdOwner<T>::_tid)) {
+                if (node->parent != nullptr) {
+                    continue;
+                }
+
+                if (auto targetNode = node->As<T>()) {
+                    return targetNode;
                 }
             }
 
@@ -188,4 +552,4 @@ class NodeStorage {
 
 } // namespace cen
 
-#endif // CENGINE_STORAGE_H_
\ No newline at end of file
+#endif // CENGINE_STORAGE_H_
@@ -7,6 +7,7 @@
 #include <cstring>
 #include <mutex>
 #include <atomic>
+#include <array>
 #include "view.h"
 #include "gui.h"
 #include "node_storage.h"
@@ -14,360 +15,458 @@
 
 namespace cen {
 
-#define render_buffer std::vector<std::unique_ptr<CanvasItem2D>>
+// # Render commands
+// Plain data copied from nodes every sync, buffers are reused between frames
+// (text is copied into buffer text storage), so sync doesn't allocate once
+// buffers are warm. Render dispatches on command type.
 
-class CanvasItem2D {
-    public:
-        node_id_t id;
-        int zOrder;
-        Vector2 position;
-        float alpha;
+struct LineRenderCommand {
+    float length;
+    Color color;
+    // # Radians
+    float rotation;
+};
 
-        CanvasItem2D(
-            Vector2 position,
-            float alpha,
-            int zOrder,
-            uint16_t id = 0
-        ) {
-            this->position = position;
-            this->zOrder = zOrder;
-            this->alpha = alpha;
-            this->id = id;
-        }
+struct CircleRenderCommand {
+    float radius;
+    Color color;
+    bool fill;
+};
 
-        virtual ~CanvasItem2D() {}
-        virtual void Render() = 0;
+struct RectangleRenderCommand {
+    cen::Size size;
+    Color color;
+    // # Radians
+    float rotation;
 };
 
-class LineCanvasItem2D: public CanvasItem2D {
-    public:
-        float length;
-        float alpha;
-        Color color;
+// # Text in RenderBuffer::text (null terminated)
+struct RenderTextRange {
+    uint32_t offset;
+    uint32_t length;
+};
 
-        LineCanvasItem2D(
-            Vector2 position,
-            float length,
-            Color color = WHITE,
-            float alpha = 1.0f,
-            int zOrder = 0,
-            uint16_t id = 0
-        ): CanvasItem2D(position, alpha, zOrder, id) {
-            this->length = length;
-            this->alpha = alpha;
-            this->color = color;
-        }
+struct ButtonRenderCommand {
+    cen::BtnState state;
+    RenderTextRange text;
+    int fontSize;
+    Vector2 anchor;
+    Rectangle btnRect;
+};
 
-        void Render() override {            Vector2 end = {
-                this->position.x,
-                this->position.y + this->length
-            };
-            DrawLineV(this->position, end, ColorAlpha(this->color, this->alpha));
-        }
+struct TextRenderCommand {
+    RenderTextRange text;
+    int fontSize;
+    Color color;
+};
+
+struct RenderCommand {
+    enum class Type: uint8_t {
+        Line,
+        Circle,
+        Rectangle,
+        Button,
+        Text
+    } type;
+
+    node_id_t id;
+    int zOrder;
+    // # Add sequence of node, commands with same zOrder are drawn in order nodes were added
+    uint64_t order;
+    Vector2 position;
+    float alpha;
+
+    union {
+        LineRenderCommand line;
+        CircleRenderCommand circle;
+        RectangleRenderCommand rectangle;
+        ButtonRenderCommand button;
+        TextRenderCommand text;
+    };
 };
 
-class CircleCanvasItem2D: public CanvasItem2D {
+class RenderBuffer {
     public:
-        float radius;
-        Color color;
-        bool fill;
+        std::vector<RenderCommand> commands;
+        std::vector<char> text;
 
-        CircleCanvasItem2D(
-            Vector2 position,
-            float radius,
-            Color color = WHITE,
-            float alpha = 1.0f,
-            bool fill = true,
-            int zOrder = 0,
-            uint16_t id = 0
-        ): CanvasItem2D(position, alpha, zOrder, id) {
-            this->radius = radius;
-            this->color = color;
-            this->fill = fill;
+        void Clear() {
+            this->commands.clear();
+            this->text.clear();
         }
 
-        void Render() override {
-            if (this->fill) {
-                DrawCircleV(this->position, this->radius, ColorAlpha(this->color, this->alpha));
-                return;
-            }
-
-            DrawCircleLinesV(this->position, this->radius, ColorAlpha(this->color, this->alpha));
+        RenderCommand& Add(
+            RenderCommand::Type type,
+            Vector2 position,
+            float alpha,
+            int zOrder,
+            node_id_t id
+        ) {
+            auto& command = this->commands.emplace_back();
+            command.type = type;
+            command.position = position;
+            command.alpha = alpha;
+            command.zOrder = zOrder;
+            command.id = id;
+
+            return command;
         }
-};
 
-class RectangleCanvasItem2D: public CanvasItem2D {
-    public:
-        cen::Size size;
-        Color color;
+        RenderTextRange AddText(const char* value, size_t length) {
+            RenderTextRange result = {
+                static_cast<uint32_t>(this->text.size()),
+                static_cast<uint32_t>(length)
+            };
 
-        RectangleCanvasItem2D(
-            Vector2 position,
-            cen::Size size,
-            Color color = WHITE,
-            float alpha = 1.0f,
-            int zOrder = 0,
-            uint16_t id = 0
-        ): CanvasItem2D(position, alpha, zOrder, id) {
-            this->size = size;
-            this->color = color;
+            this->text.insert(this->text.end(), value, value + length);
+            this->text.push_back('\0');
+
+            return result;
         }
 
-        void Render() override {
-            DrawRectangle(this->position.x - this->size.width * 0.5, this->position.y - this->size.height * 0.5, this->size.width, this->size.height, ColorAlpha(this->color, this->alpha));
+        const char* Text(RenderTextRange value) const {
+            return this->text.data() + value.offset;
         }
 };
 
-class ButtonCanvasItem2D: public CanvasItem2D {
-    public:
-        cen::BtnState state = cen::BtnState::Normal;
-        const char* text;
-        int fontSize;
-        Vector2 anchor;
-        Rectangle btnRect;
+static void RenderLine(const RenderCommand& command) {
+    const auto& line = command.line;
+    Vector2 end = Vector2Add(
+        command.position,
+        Vector2Rotate(Vector2{ 0, line.length }, line.rotation)
+    );
+    DrawLineV(command.position, end, ColorAlpha(line.color, command.alpha));
+}
 
-        ButtonCanvasItem2D(
-            Vector2 position,
-            cen::BtnState state,
-            const char* btnText,
-            int btnTextFontSize,
-            cen::Size size,
-            Vector2 anchor,
-            float alpha = 1.0f,
-            int zOrder = 0,
-            node_id_t id = 0
-        ): CanvasItem2D(position, alpha, zOrder, id) {
-            this->state = state;
-            this->text = btnText;
-            this->fontSize = btnTextFontSize;
-            this->anchor = anchor;
-
-            float width = size.width;
-            float height = size.height;
+static void RenderCircle(const RenderCommand& command) {
+    const auto& circle = command.circle;
 
-            if (width == 0 || height == 0) {
-                width = MeasureText(this->text, this->fontSize) * 2;
-                height = (float)this->fontSize * 2;
-            }
-
-            this->btnRect = Rectangle{
-                this->position.x - width * this->anchor.x,
-                this->position.y - height * this->anchor.y,
-                width,
-                height
-            };
-        }
+    if (circle.fill) {
+        DrawCircleV(command.position, circle.radius, ColorAlpha(circle.color, command.alpha));
+        return;
+    }
 
-        void Render() override {            switch (state) {
-                case BtnState::Normal:
-                    DrawRectangleRec(
-                        btnRect,
-                        ColorAlpha(WHITE, 0.5f)
-                    );
-                    break;
-                case BtnState::Hover:
-                    DrawRectangleRec(
-                        btnRect,
-                        ColorAlpha(WHITE, 0.75f)
-                    );
-                    break;
-                case BtnState::Pressing:
-                    DrawRectangleRec(
-                        btnRect,
-                        ColorAlpha(WHITE, 1.0f)
-                    );
-                    break;
-            }
+    DrawCircleLinesV(command.position, circle.radius, ColorAlpha(circle.color, command.alpha));
+}
 
+static void RenderRectangle(const RenderCommand& command) {
+    const auto& rectangle = command.rectangle;
 
-            DrawText(
-                this->text,
-                this->position.x - MeasureText(this->text, this->fontSize) * this->anchor.x,
-                this->position.y - this->fontSize * this->anchor.y,
-                this->fontSize,
-                BLACK
-            );
-        }
-};
+    if (rectangle.rotation != 0) {
+        DrawRectanglePro(
+            Rectangle{ command.position.x, command.position.y, rectangle.size.width, rectangle.size.height },
+            Vector2{ rectangle.size.width * 0.5f, rectangle.size.height * 0.5f },
+            rectangle.rotation * RAD2DEG,
+            ColorAlpha(rectangle.color, command.alpha)
+        );
+        return;
+    }
 
-class TextCanvasItem2D: public CanvasItem2D {
-    public:
-        std::string text;
-        int fontSize;
-        Color color;
+    DrawRectangle(command.position.x - rectangle.size.width * 0.5, command.position.y - rectangle.size.height * 0.5, rectangle.size.width, rectangle.size.height, ColorAlpha(rectangle.color, command.alpha));
+}
 
-        TextCanvasItem2D(
-            Vector2 position,
-            std::string text,
-            int fontSize,
-            Color color,
-            float alpha = 1.0f,
-            int zOrder = 0
-        ): CanvasItem2D(position, alpha, zOrder) {
-            this->text = text;
-            this->fontSize = fontSize;
-            this->color = color;
-        }
+static void RenderButton(const RenderBuffer& buffer, const RenderCommand& command) {
+    const auto& button = command.button;
+    auto text = buffer.Text(button.text);
 
-        void Render() override {
-            DrawText(
-                this->text.c_str(),
-                this->position.x,
-                this->position.y,
-                this->fontSize,
-                this->color
+    switch (button.state) {
+        case BtnState::Normal:
+            DrawRectangleRec(
+                button.btnRect,
+                ColorAlpha(WHITE, 0.5f)
             );
-        }
-};
-
-// # TileMapLayer
+            break;
+        case BtnState::Hover:
+            DrawRectangleRec(
+                button.btnRect,
+                ColorAlpha(WHITE, 0.75f)
+            );
+            break;
+        case BtnState::Pressing:
+            DrawRectangleRec(
+                button.btnRect,
+                ColorAlpha(WHITE, 1.0f)
+            );
+            break;
+    }
+
+    DrawText(
+        text,
+        command.position.x - MeasureText(text, button.fontSize) * button.anchor.x,
+        command.position.y - button.fontSize * button.anchor.y,
+        button.fontSize,
+        BLACK
+    );
+}
 
-class TileMapLayerCanvasItem2D: public CanvasItem2D {
-    public:
-        
+static void RenderText(const RenderBuffer& buffer, const RenderCommand& command) {
+    const auto& text = command.text;
 
-        TileMapLayerCanvasItem2D(
-            Vector2 position,
-            float alpha = 1.0f,
-            int zOrder = 0,
-            uint16_t id = 0
-        ): CanvasItem2D(position, alpha, zOrder, id) {
-        }
+    DrawText(
+        buffer.Text(text.text),
+        command.position.x,
+        command.position.y,
+        text.fontSize,
+        text.color
+    );
+}
 
-        void Render() override {
-            
+static void RenderCommands(const RenderBuffer& buffer) {
+    for (const auto& command: buffer.commands) {
+        switch (command.type) {
+            case RenderCommand::Type::Line:
+                RenderLine(command);
+                break;
+            case RenderCommand::Type::Circle:
+                RenderCircle(command);
+                break;
+            case RenderCommand::Type::Rectangle:
+                RenderRectangle(command);
+                break;
+            case RenderCommand::Type::Button:
+                RenderButton(buffer, command);
+                break;
+            case RenderCommand::Type::Text:
+                RenderText(buffer, command);
+                break;
         }
-};
+    }
+}
 
 // # Rendering Engine
 
+// # Triple buffer
+// Simulation thread writes into its own buffer and publishes it by swapping it
+// with the middle one, render thread takes the middle one only when it holds
+// a new frame. Every buffer is owned by one thread at a time, so neither thread
+// waits for the other or touches buffer the other one is using.
+
 class RenderingEngine2D {
     private:
-        std::atomic<int> activeRenderBufferInd;
+        static constexpr uint8_t BufferIndexMask = 0b011;
+        // ## Middle buffer holds frame render thread hasn't taken yet
+        static constexpr uint8_t FreshFrameBit = 0b100;
+
+        std::array<RenderBuffer, 3> buffers;
+        // ## Owned by simulation thread
+        uint8_t writeBufferInd = 0;
+        // ## Index of middle buffer (and FreshFrameBit), exchanged by both threads
+        std::atomic<uint8_t> middleBufferInd = 1;
+        // ## Owned by render thread
+        uint8_t readBufferInd = 2;
+
+        // # Simulation thread, makes written buffer the middle one
+        void PublishRenderBuffer() {
+            auto previous = this->middleBufferInd.exchange(
+                this->writeBufferInd | FreshFrameBit,
+                std::memory_order_acq_rel
+            );
 
-    public:
-        render_buffer firstBuffer;
-        render_buffer secondBuffer;
+            this->writeBufferInd = previous & BufferIndexMask;
+        }
 
-        void MapNode2D(
-            render_buffer& activeRenderBuffer,
+        // # Render thread, latest published buffer (last one when nothing new was published)
+        const RenderBuffer& AcquireRenderBuffer() {
+            if (this->middleBufferInd.load(std::memory_order_relaxed) & FreshFrameBit) {
+                auto previous = this->middleBufferInd.exchange(
+                    this->readBufferInd,
+                    std::memory_order_acq_rel
+                );
+
+                this->readBufferInd = previous & BufferIndexMask;
+            }
+
+            return this->buffers[this->readBufferInd];
+        }
+
+    public:
+        Vector2 InterpolatedGlobalPosition(
             cen::Node2D* node2D,
             float alpha
         ) {
             Vector2 position = node2D->GlobalPosition();
             Vector2 previousPosition = node2D->PreviousGlobalPosition();
 
-            Vector2 newGlobalPosition = Vector2Lerp(
+            return Vector2Lerp(
                 previousPosition,
                 position,
                 alpha
             );
+        }
 
-            if (auto lineView = dynamic_cast<cen::LineView*>(node2D)) {
-                activeRenderBuffer.push_back(
-                    std::make_unique<LineCanvasItem2D>(
-                        newGlobalPosition,
-                        lineView->length,
-                        lineView->color,
-                        lineView->alpha,
-                        lineView->zOrder,
-                        lineView->id
-                    )
-                );
-            } else if (auto circleView = dynamic_cast<cen::CircleView*>(node2D)) {
-                activeRenderBuffer.push_back(
-                    std::make_unique<CircleCanvasItem2D>(
-                        newGlobalPosition,
-                        circleView->radius,
-                        circleView->color,
-                        circleView->alpha,
-                        circleView->fill,
-                        circleView->zOrder,
-                        circleView->id
-                    )
-                );
-            } else if (auto rectangleView = dynamic_cast<cen::RectangleView*>(node2D)) {
-                activeRenderBuffer.push_back(
-                    std::make_unique<RectangleCanvasItem2D>(
-                        newGlobalPosition,
-                        rectangleView->size,
-                        rectangleView->color,
-                        rectangleView->alpha,
-                        rectangleView->zOrder,
-                        rectangleView->id
-                    )
-                );
-            } else if (auto buttonView = dynamic_cast<cen::Btn*>(node2D)) {
-                activeRenderBuffer.push_back(
-                    std::make_unique<ButtonCanvasItem2D>(
-                        newGlobalPosition,
-                        buttonView->state,
-                        buttonView->text,
-                        buttonView->fontSize,
-                        buttonView->size,
-                        buttonView->anchor
-                    )
-                );
-            } else if (auto textView = dynamic_cast<cen::TextView*>(node2D)) {
-                activeRenderBuffer.push_back(
-                    std::make_unique<TextCanvasItem2D>(
-                        newGlobalPosition,
-                        std::string(textView->text).c_str(),
-                        textView->fontSize,
-                        textView->color
-                    )
-                );
-            } else if (auto tileMapView = dynamic_cast<cen::TileMapView*>(node2D)) {
-                for (auto layer : tileMapView->map->layers) {
-                    
-                }
+        void MapNode2D(
+            RenderBuffer& activeRenderBuffer,
+            cen::LineView* lineView,
+            Vector2 newGlobalPosition
+        ) {
+            // # Rotation and scale from cached global transform
+            const auto& transform = lineView->GlobalTransform();
+
+            auto& command = activeRenderBuffer.Add(
+                RenderCommand::Type::Line,
+                newGlobalPosition,
+                lineView->alpha,
+                lineView->zOrder,
+                lineView->id
+            );
+            command.line = {
+                lineView->length * Transform2DScale(transform).y,
+                lineView->color,
+                Transform2DRotation(transform)
+            };
+        }
+
+        void MapNode2D(
+            RenderBuffer& activeRenderBuffer,
+            cen::CircleView* circleView,
+            Vector2 newGlobalPosition
+        ) {
+            auto scale = Vector2Abs(Transform2DScale(circleView->GlobalTransform()));
+
+            auto& command = activeRenderBuffer.Add(
+                RenderCommand::Type::Circle,
+                newGlobalPosition,
+                circleView->alpha,
+                circleView->zOrder,
+                circleView->id
+            );
+            command.circle = {
+                circleView->radius * std::max(scale.x, scale.y),
+                circleView->color,
+                circleView->fill
+            };
+        }
+
+        void MapNode2D(
+            RenderBuffer& activeRenderBuffer,
+            cen::RectangleView* rectangleView,
+            Vector2 newGlobalPosition
+        ) {
+            const auto& transform = rectangleView->GlobalTransform();
+            auto scale = Vector2Abs(Transform2DScale(transform));
+
+            auto& command = activeRenderBuffer.Add(
+                RenderCommand::Type::Rectangle,
+                newGlobalPosition,
+                rectangleView->alpha,
+                rectangleView->zOrder,
+                rectangleView->id
+            );
+            command.rectangle = {
+                cen::Size{ rectangleView->size.width * scale.x, rectangleView->size.height * scale.y },
+                rectangleView->color,
+                Transform2DRotation(transform)
+            };
+        }
+
+        void MapNode2D(
+            RenderBuffer& activeRenderBuffer,
+            cen::Btn* buttonView,
+            Vector2 newGlobalPosition
+        ) {
+            float width = buttonView->size.width;
+            float height = buttonView->size.height;
+
+            if (width == 0 || height == 0) {
+                width = MeasureText(buttonView->text, buttonView->fontSize) * 2;
+                height = (float)buttonView->fontSize * 2;
             }
+
+            auto& command = activeRenderBuffer.Add(
+                RenderCommand::Type::Button,
+                newGlobalPosition,
+                1.0f,
+                0,
+                0
+            );
+            command.button = {
+                buttonView->state,
+                activeRenderBuffer.AddText(buttonView->text, std::strlen(buttonView->text)),
+                buttonView->fontSize,
+                buttonView->anchor,
+                Rectangle{
+                    newGlobalPosition.x - width * buttonView->anchor.x,
+                    newGlobalPosition.y - height * buttonView->anchor.y,
+                    width,
+                    height
+                }
+            };
         }
 
-        void SyncRenderBuffer(
+        void MapNode2D(
+            RenderBuffer& activeRenderBuffer,
+            cen::TextView* textView,
+            Vector2 newGlobalPosition
+        ) {
+            auto& command = activeRenderBuffer.Add(
+                RenderCommand::Type::Text,
+                newGlobalPosition,
+                1.0f,
+                0,
+                0
+            );
+            command.text = {
+                activeRenderBuffer.AddText(textView->text.data(), textView->text.size()),
+                textView->fontSize,
+                textView->color
+            };
+        }
+
+        // # Maps only nodes of T (and derived) using type index
+        template <typename T>
+        void MapNodesByType(
+            RenderBuffer& activeRenderBuffer,
             cen::NodeStorage* const nodeStorage,
             float alpha
         ) {
-            auto writeBuffer = render_buffer();
+            for (auto node: nodeStorage->GetAllByType<T>()) {
+                auto view = static_cast<T*>(node);
 
-            // # Sync with game Nodes
-            for (auto const& node: nodeStorage->renderNodes) {
-                if (node->AnyParentDeactivated()) {
+                if (view->AnyParentDeactivated()) {
                     continue;
                 }
 
+                auto first = activeRenderBuffer.commands.size();
+
                 this->MapNode2D(
-                    writeBuffer,
-                    node,
-                    alpha
+                    activeRenderBuffer,
+                    view,
+                    this->InterpolatedGlobalPosition(view, alpha)
                 );
-            }
 
-            std::sort(writeBuffer.begin(),writeBuffer.end(), [](const std::unique_ptr<cen::CanvasItem2D>& a, const std::unique_ptr<cen::CanvasItem2D>& b) {
-                return a->zOrder < b->zOrder;
-            });
+                auto order = nodeStorage->AddSequenceOf(view);
 
-            {
-                if (activeRenderBufferInd.load(std::memory_order_acquire) == 0) {
-                    secondBuffer = std::move(writeBuffer);
-                    activeRenderBufferInd.store(1, std::memory_order_release);
-                } else {
-                    firstBuffer = std::move(writeBuffer);
-                    activeRenderBufferInd.store(0, std::memory_order_release);
+                for (auto i = first; i < activeRenderBuffer.commands.size(); i++) {
+                    activeRenderBuffer.commands[i].order = order;
                 }
             }
         }
 
+        void SyncRenderBuffer(
+            cen::NodeStorage* const nodeStorage,
+            float alpha
+        ) {
+            // # Owned by simulation thread until published, reused (keeps its capacity)
+            auto& writeBuffer = this->buffers[this->writeBufferInd];
+
+            writeBuffer.Clear();
+
+            // # Sync with game Nodes
+            this->MapNodesByType<cen::LineView>(writeBuffer, nodeStorage, alpha);
+            this->MapNodesByType<cen::CircleView>(writeBuffer, nodeStorage, alpha);
+            this->MapNodesByType<cen::RectangleView>(writeBuffer, nodeStorage, alpha);
+            this->MapNodesByType<cen::Btn>(writeBuffer, nodeStorage, alpha);
+            this->MapNodesByType<cen::TextView>(writeBuffer, nodeStorage, alpha);
+
+            std::sort(writeBuffer.commands.begin(), writeBuffer.commands.end(), [](const RenderCommand& a, const RenderCommand& b) {
+                return a.zOrder < b.zOrder || (a.zOrder == b.zOrder && a.order < b.order);
+            });
+
+            this->PublishRenderBuffer();
+        }
+
         void Render() {
-            if (activeRenderBufferInd.load(std::memory_order_acquire) == 0) {
-                for (const auto& item: firstBuffer) {
-                    item->Render();
-                }
-            } else {
-                for (const auto& item: secondBuffer) {
-                    item->Render();
-                }
-            }
+            RenderCommands(this->AcquireRenderBuffer());
         };
 
         int Run() {
@@ -87,8 +87,8 @@ namespace cen {
                 this->Init();
 
                 // ## Init Nodes
-                for (const auto& node: this->nodeStorage->rootNodes) {
-                    node->TraverseInit();
+                for (size_t i = 0; i < this->nodeStorage->rootNodes.size(); i++) {
+                    this->nodeStorage->rootNodes[i]->TraverseInit();
                 }
 
                 // ## Node Storage
@@ -99,23 +99,35 @@ namespace cen {
 
             void FixedSimulationTick() {
                 // # Invalidate previous
-                for (const auto& node: this->nodeStorage->rootNodes) {
-                    node->TraverseInvalidatePrevious();
-                }
+                this->nodeStorage->TraverseActivated([](Node* node) {
+                    node->InvalidatePrevious();
+                });
 
                 // # Fixed Update
-                for (const auto& node: this->nodeStorage->rootNodes) {
-                    node->TraverseFixedUpdate();
-                }
+                this->nodeStorage->TraverseActivated([](Node* node) {
+                    node->FixedUpdate();
+                });
+
+                // # Global transforms
+                this->nodeStorage->UpdateGlobalTransforms();
 
                 // # Collision
-                this->collisionEngine->NarrowCollisionCheckNaive(this->nodeStorage.get());
+                this->collisionEngine->CollisionCheck(this->nodeStorage.get());
+
+                // # Destroy nodes removed during tick
+                this->nodeStorage->FlushRemovals();
             }
 
             template <typename T>
             T* AddNode(std::unique_ptr<T> newNode) {
                 return this->nodeStorage->AddNode(std::move(newNode));
             }
+
+            // # Node constructed in scene pool
+            template <typename T, typename... Args>
+            T* AddNode(Args&&... args) {
+                return this->nodeStorage->AddNode<T>(std::forward<Args>(args)...);
+            }
     };
 
     class LocalScene: public Scene {
@@ -203,14 +215,19 @@ namespace cen {
                     }
 
                     // # Initial
-                    for (const auto& node: this->nodeStorage->rootNodes) {
-                        node->TraverseUpdate();
-                    }
+                    this->nodeStorage->TraverseActivated([](Node* node) {
+                        node->Update();
+                    });
 
                     // # Flush events
                     this->eventBus.Flush();
 
+                    // # Destroy removed nodes
+                    this->nodeStorage->FlushRemovals();
+
                     // # Sync GameState and RendererState
+                    this->nodeStorage->UpdateGlobalTransforms();
+
                     auto alpha = static_cast<double>(accumulatedFixedTime.count()) / fixedSimulationFrameRateInMs.count();
 
                     this->renderingEngine->SyncRenderBuffer(
@@ -0,0 +1,80 @@
+#ifndef CENGINE_SPATIAL_HASH_GRID_H
+#define CENGINE_SPATIAL_HASH_GRID_H
+
+#include <algorithm>
+#include "broadphase.h"
+#include "grid_cells.h"
+
+namespace cen {
+
+class SpatialHashGrid: public Broadphase {
+    private:
+        // # Reused between ticks to avoid reallocation
+        std::vector<GridCellEntry> cellEntries;
+
+    public:
+        float cellSize;
+
+        SpatialHashGrid(float cellSize = 64.0f) {
+            this->cellSize = cellSize;
+        }
+
+        void FindPairs(
+            const std::vector<BroadphaseProxy>& proxies,
+            std::vector<BroadphasePair>& pairs
+        ) override {
+            this->cellEntries.clear();
+
+            // # Insert every proxy in every cell it touches
+            for (uint32_t i = 0; i < proxies.size(); i++) {
+                GridInsert(this->cellEntries, proxies[i].bounds, i, this->cellSize);
+            }
+
+            std::sort(this->cellEntries.begin(), this->cellEntries.end());
+
+            // # Test proxies sharing a cell
+            size_t runStart = 0;
+            while (runStart < this->cellEntries.size()) {
+                auto key = this->cellEntries[runStart].key;
+                size_t runEnd = runStart + 1;
+                while (runEnd < this->cellEntries.size() && this->cellEntries[runEnd].key == key) {
+                    runEnd++;
+                }
+
+                for (auto i = runStart; i < runEnd; i++) {
+                    const auto a = this->cellEntries[i].proxy;
+                    const auto& boundsA = proxies[a].bounds;
+
+                    for (auto j = i + 1; j < runEnd; j++) {
+                        const auto b = this->cellEntries[j].proxy;
+                        const auto& boundsB = proxies[b].bounds;
+
+                        if (!ProxiesLayersMatch(proxies[a], proxies[b]) || !AABBOverlap(boundsA, boundsB)) {
+                            continue;
+                        }
+
+                        if (GridOverlapOwnerKey(boundsA, boundsB, this->cellSize) != key) {
+                            continue;
+                        }
+
+                        pairs.push_back({ a, b });
+                    }
+                }
+
+                runStart = runEnd;
+            }
+        }
+
+        void Query(
+            const AABB& bounds,
+            std::vector<uint32_t>& found
+        ) const override {
+            GridQuery(this->cellEntries, bounds, this->cellSize, [&](uint64_t, uint32_t proxy) {
+                found.push_back(proxy);
+            });
+        }
+};
+
+} // namespace cen
+
+#endif // CENGINE_SPATIAL_HASH_GRID_H
@@ -0,0 +1,63 @@
+#ifndef CENGINE_STATIC_GRID_H
+#define CENGINE_STATIC_GRID_H
+
+#include <algorithm>
+#include "broadphase.h"
+#include "grid_cells.h"
+
+namespace cen {
+
+// # Static grid
+// Uniform grid over colliders that don't move. Built once (sorted cell entries)
+// and only queried after that, so it is rebuilt only when static geometry changes.
+
+class StaticGrid {
+    private:
+        std::vector<GridCellEntry> cellEntries;
+        std::vector<BroadphaseProxy> proxies;
+
+    public:
+        float cellSize;
+
+        StaticGrid(float cellSize = 64.0f) {
+            this->cellSize = cellSize;
+        }
+
+        const std::vector<BroadphaseProxy>& Proxies() const {
+            return this->proxies;
+        }
+
+        void Build(const std::vector<BroadphaseProxy>& proxies) {
+            this->proxies = proxies;
+            this->cellEntries.clear();
+
+            for (uint32_t i = 0; i < this->proxies.size(); i++) {
+                GridInsert(this->cellEntries, this->proxies[i].bounds, i, this->cellSize);
+            }
+
+            std::sort(this->cellEntries.begin(), this->cellEntries.end());
+        }
+
+        // # Appends indexes of static proxies overlapping proxy (with matching layers), without duplicates
+        void Query(const BroadphaseProxy& proxy, std::vector<uint32_t>& found) const {
+            const auto& bounds = proxy.bounds;
+
+            GridQuery(this->cellEntries, bounds, this->cellSize, [&](uint64_t key, uint32_t index) {
+                const auto& other = this->proxies[index];
+
+                if (
+                    !ProxiesLayersMatch(proxy, other) ||
+                    !AABBOverlap(bounds, other.bounds) ||
+                    GridOverlapOwnerKey(bounds, other.bounds, this->cellSize) != key
+                ) {
+                    return;
+                }
+
+                found.push_back(index);
+            });
+        }
+};
+
+} // namespace cen
+
+#endif // CENGINE_STATIC_GRID_H
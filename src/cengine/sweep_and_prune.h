@@ -0,0 +1,253 @@
+#ifndef CENGINE_SWEEP_AND_PRUNE_H
+#define CENGINE_SWEEP_AND_PRUNE_H
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include "broadphase.h"
+
+namespace cen {
+
+// # Sweep and prune
+// Keeps x axis endpoints of collider bounds sorted between ticks. Bodies move
+// little per tick, so insertion sort does few swaps, and every swap of min and
+// max endpoints of two boxes starts or ends their x overlap. Pairs overlapping
+// on x are kept between ticks, y is tested only when pairs are reported.
+
+class SweepAndPrune: public Broadphase {
+    private:
+        struct Endpoint {
+            float value;
+            // # Box index << 1 | is max endpoint
+            uint32_t data;
+
+            uint32_t Box() const {
+                return this->data >> 1;
+            }
+
+            bool IsMax() const {
+                return this->data & 1;
+            }
+        };
+
+        struct Box {
+            AABB bounds;
+            node_id_t id;
+            uint32_t proxy;
+            uint64_t stamp;
+            // # Indexes of min and max endpoint
+            uint32_t endpoints[2];
+        };
+
+        std::vector<Box> boxes;
+        std::vector<uint32_t> freeBoxes;
+        std::unordered_map<node_id_t, uint32_t> boxById;
+        std::vector<Endpoint> endpoints;
+        uint64_t stamp = 0;
+
+        // # Box pairs overlapping on x
+        std::unordered_set<uint64_t> pairKeys;
+
+        // # Reused between ticks to avoid reallocation
+        std::vector<uint32_t> newProxies;
+        std::vector<uint32_t> removedBoxes;
+
+        static uint64_t PairKey(uint32_t a, uint32_t b) {
+            if (a > b) {
+                std::swap(a, b);
+            }
+
+            return (static_cast<uint64_t>(a) << 32) | b;
+        }
+
+        // # Min goes before max of same value, so touching bounds overlap (same as AABBOverlap)
+        static bool Less(const Endpoint& a, const Endpoint& b) {
+            return a.value < b.value || (a.value == b.value && !a.IsMax() && b.IsMax());
+        }
+
+        bool OverlapX(uint32_t a, uint32_t b) const {
+            const auto& boundsA = this->boxes[a].bounds;
+            const auto& boundsB = this->boxes[b].bounds;
+
+            return boundsA.min.x <= boundsB.max.x && boundsA.max.x >= boundsB.min.x;
+        }
+
+        // # Swaps endpoint at index with the one before it
+        void SwapWithPrevious(uint32_t index) {
+            auto& moving = this->endpoints[index];
+            auto& other = this->endpoints[index - 1];
+            auto movingBox = moving.Box();
+            auto otherBox = other.Box();
+
+            if (movingBox != otherBox) {
+                if (!moving.IsMax() && other.IsMax()) {
+                    // ## Min passed max to the left, boxes may start overlapping
+                    if (this->OverlapX(movingBox, otherBox)) {
+                        this->pairKeys.insert(PairKey(movingBox, otherBox));
+                    }
+                } else if (moving.IsMax() && !other.IsMax()) {
+                    // ## Max passed min to the left, boxes stop overlapping
+                    this->pairKeys.erase(PairKey(movingBox, otherBox));
+                }
+            }
+
+            std::swap(moving, other);
+            this->boxes[this->endpoints[index].Box()].endpoints[this->endpoints[index].IsMax()] = index;
+            this->boxes[this->endpoints[index - 1].Box()].endpoints[this->endpoints[index - 1].IsMax()] = index - 1;
+        }
+
+        void SiftLeft(uint32_t index) {
+            while (index > 0 && Less(this->endpoints[index], this->endpoints[index - 1])) {
+                this->SwapWithPrevious(index);
+                index--;
+            }
+        }
+
+        void SiftRight(uint32_t index) {
+            while (index + 1 < this->endpoints.size() && Less(this->endpoints[index + 1], this->endpoints[index])) {
+                this->SwapWithPrevious(index + 1);
+                index++;
+            }
+        }
+
+        void InsertBox(const BroadphaseProxy& proxy, uint32_t proxyIndex) {
+            uint32_t box;
+
+            if (this->freeBoxes.empty()) {
+                box = static_cast<uint32_t>(this->boxes.size());
+                this->boxes.push_back({});
+            } else {
+                box = this->freeBoxes.back();
+                this->freeBoxes.pop_back();
+            }
+
+            auto& newBox = this->boxes[box];
+            newBox.bounds = proxy.bounds;
+            newBox.id = proxy.id;
+            newBox.proxy = proxyIndex;
+            newBox.stamp = this->stamp;
+            this->boxById[proxy.id] = box;
+
+            // # Endpoints come in from the right end
+            auto minIndex = static_cast<uint32_t>(this->endpoints.size());
+            this->endpoints.push_back({ proxy.bounds.min.x, box << 1 });
+            this->endpoints.push_back({ proxy.bounds.max.x, (box << 1) | 1 });
+            newBox.endpoints[0] = minIndex;
+            newBox.endpoints[1] = minIndex + 1;
+
+            this->SiftLeft(minIndex);
+            this->SiftLeft(minIndex + 1);
+        }
+
+        void RemoveBox(uint32_t box) {
+            // # Endpoints leave through the right end, ending every overlap on the way
+            constexpr auto infinity = std::numeric_limits<float>::infinity();
+            auto& removedBox = this->boxes[box];
+            removedBox.bounds = { { infinity, infinity }, { infinity, infinity } };
+
+            this->endpoints[removedBox.endpoints[1]].value = infinity;
+            this->SiftRight(removedBox.endpoints[1]);
+            this->endpoints[removedBox.endpoints[0]].value = infinity;
+            this->SiftRight(removedBox.endpoints[0]);
+
+            this->endpoints.pop_back();
+            this->endpoints.pop_back();
+            this->freeBoxes.push_back(box);
+        }
+
+    public:
+        void FindPairs(
+            const std::vector<BroadphaseProxy>& proxies,
+            std::vector<BroadphasePair>& pairs
+        ) override {
+            this->stamp++;
+            this->newProxies.clear();
+            this->removedBoxes.clear();
+
+            // # Match proxies with boxes
+            for (uint32_t i = 0; i < proxies.size(); i++) {
+                auto found = this->boxById.find(proxies[i].id);
+
+                if (found == this->boxById.end()) {
+                    this->newProxies.push_back(i);
+                    continue;
+                }
+
+                auto& box = this->boxes[found->second];
+                box.proxy = i;
+                box.stamp = this->stamp;
+            }
+
+            // # Remove boxes of colliders that are gone (while endpoints are still sorted)
+            for (auto it = this->boxById.begin(); it != this->boxById.end();) {
+                if (this->boxes[it->second].stamp != this->stamp) {
+                    this->removedBoxes.push_back(it->second);
+                    it = this->boxById.erase(it);
+                } else {
+                    it++;
+                }
+            }
+
+            for (auto box: this->removedBoxes) {
+                this->RemoveBox(box);
+            }
+
+            // # Move endpoints and restore order, swaps update pairs
+            for (const auto& [id, boxIndex]: this->boxById) {
+                auto& box = this->boxes[boxIndex];
+                const auto& bounds = proxies[box.proxy].bounds;
+
+                box.bounds = bounds;
+                this->endpoints[box.endpoints[0]].value = bounds.min.x;
+                this->endpoints[box.endpoints[1]].value = bounds.max.x;
+            }
+
+            for (uint32_t i = 1; i < this->endpoints.size(); i++) {
+                this->SiftLeft(i);
+            }
+
+            // # New boxes are inserted into sorted endpoints
+            for (auto proxyIndex: this->newProxies) {
+                this->InsertBox(proxies[proxyIndex], proxyIndex);
+            }
+
+            // # Report pairs overlapping on y too
+            for (auto key: this->pairKeys) {
+                auto a = this->boxes[static_cast<uint32_t>(key >> 32)].proxy;
+                auto b = this->boxes[static_cast<uint32_t>(key & 0xFFFFFFFF)].proxy;
+
+                if (!ProxiesLayersMatch(proxies[a], proxies[b]) || !AABBOverlap(proxies[a].bounds, proxies[b].bounds)) {
+                    continue;
+                }
+
+                pairs.push_back({ std::min(a, b), std::max(a, b) });
+            }
+        }
+
+        // # Boxes starting before bounds end on x (endpoints are sorted)
+        void Query(
+            const AABB& bounds,
+            std::vector<uint32_t>& found
+        ) const override {
+            for (const auto& endpoint: this->endpoints) {
+                if (endpoint.value > bounds.max.x) {
+                    break;
+                }
+
+                if (endpoint.IsMax()) {
+                    continue;
+                }
+
+                const auto& box = this->boxes[endpoint.Box()];
+
+                if (AABBOverlap(box.bounds, bounds)) {
+                    found.push_back(box.proxy);
+                }
+            }
+        }
+};
+
+} // namespace cen
+
+#endif // CENGINE_SWEEP_AND_PRUNE_H
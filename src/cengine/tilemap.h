@@ -45,6 +45,79 @@ namespace cen {
         std::vector<TileMapLayer> layers;
         std::unordered_map<std::string, std::unique_ptr<TileSet>> tileSets;
     };
+
+    // # Rectangle of cells (x, y of top left cell)
+    struct TileRect {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    // # Solid cells of layer merged into maximal rectangles (greedy, row by row:
+    // widest run of free solid cells, then grown down while whole run is solid),
+    // so large walls become few colliders instead of one per tile
+    template <typename F>
+    void MergeSolidTiles(
+        const TileMapLayer& layer,
+        F&& isSolid,
+        std::vector<TileRect>& rects
+    ) {
+        std::vector<bool> merged(layer.data.size(), false);
+
+        auto free = [&](int x, int y) {
+            auto cell = y * layer.width + x;
+            return !merged[cell] && isSolid(layer.data[cell]);
+        };
+
+        for (int y = 0; y < layer.height; y++) {
+            for (int x = 0; x < layer.width; x++) {
+                if (!free(x, y)) {
+                    continue;
+                }
+
+                int width = 1;
+                while (x + width < layer.width && free(x + width, y)) {
+                    width++;
+                }
+
+                int height = 1;
+                while (y + height < layer.height) {
+                    bool rowFree = true;
+
+                    for (int i = x; i < x + width; i++) {
+                        if (!free(i, y + height)) {
+                            rowFree = false;
+                            break;
+                        }
+                    }
+
+                    if (!rowFree) {
+                        break;
+                    }
+
+                    height++;
+                }
+
+                for (int j = y; j < y + height; j++) {
+                    for (int i = x; i < x + width; i++) {
+                        merged[j * layer.width + i] = true;
+                    }
+                }
+
+                rects.push_back({ x, y, width, height });
+                x += width - 1;
+            }
+        }
+    }
+
+    // # Every non empty tile (gid 0) is solid
+    inline void MergeSolidTiles(
+        const TileMapLayer& layer,
+        std::vector<TileRect>& rects
+    ) {
+        MergeSolidTiles(layer, [](int gid) { return gid != 0; }, rects);
+    }
 }
 
 #endif // CEN_TILEMAP_H
\ No newline at end of file
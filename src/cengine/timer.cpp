@@ -0,0 +1,8 @@
+#include "scene.h"
+#include "timer.h"
+
+namespace cen {
+
+const uint64_t Timer::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node::_tid);
+
+} // namespace cen
\ No newline at end of file
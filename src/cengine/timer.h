@@ -13,6 +13,12 @@ enum class TimerMode {
 
 class Timer: public Node {
     public:
+        static const uint64_t _tid;
+
+        cen::type_id_t TypeId() const override {
+            return Timer::_tid;
+        }
+
         float createdAt;
         int triggerAfter;
         TimerMode mode;
@@ -0,0 +1,95 @@
+#ifndef CENGINE_TRANSFORM_2D_H
+#define CENGINE_TRANSFORM_2D_H
+
+#include <cmath>
+#include "core.h"
+
+namespace cen {
+
+// # Transform 2D
+// Affine matrix
+// | a c x |
+// | b d y |
+// | 0 0 1 |
+// (a, b) is X axis, (c, d) is Y axis and (x, y) is origin
+
+struct Transform2D {
+    float a;
+    float b;
+    float c;
+    float d;
+    float x;
+    float y;
+};
+
+constexpr Transform2D Transform2DIdentity { 1, 0, 0, 1, 0, 0 };
+
+// # Scale, then rotate (radians), then translate
+inline Transform2D Transform2DFrom(Vector2 position, float rotation, Vector2 scale) {
+    if (rotation == 0) {
+        return Transform2D{ scale.x, 0, 0, scale.y, position.x, position.y };
+    }
+
+    auto cos = std::cos(rotation);
+    auto sin = std::sin(rotation);
+
+    return Transform2D{
+        cos * scale.x,
+        sin * scale.x,
+        -sin * scale.y,
+        cos * scale.y,
+        position.x,
+        position.y
+    };
+}
+
+inline Vector2 Transform2DApply(const Transform2D& t, Vector2 point) {
+    return Vector2{
+        t.a * point.x + t.c * point.y + t.x,
+        t.b * point.x + t.d * point.y + t.y
+    };
+}
+
+// # Same as applying local and then parent
+inline Transform2D Transform2DMultiply(const Transform2D& parent, const Transform2D& local) {
+    auto origin = Transform2DApply(parent, Vector2{ local.x, local.y });
+
+    return Transform2D{
+        parent.a * local.a + parent.c * local.b,
+        parent.b * local.a + parent.d * local.b,
+        parent.a * local.c + parent.c * local.d,
+        parent.b * local.c + parent.d * local.d,
+        origin.x,
+        origin.y
+    };
+}
+
+inline bool Transform2DEqual(const Transform2D& t, const Transform2D& other) {
+    return t.a == other.a && t.b == other.b && t.c == other.c &&
+        t.d == other.d && t.x == other.x && t.y == other.y;
+}
+
+inline Vector2 Transform2DOrigin(const Transform2D& t) {
+    return Vector2{ t.x, t.y };
+}
+
+inline float Transform2DRotation(const Transform2D& t) {
+    return std::atan2(t.b, t.a);
+}
+
+inline Vector2 Transform2DScale(const Transform2D& t) {
+    auto determinant = t.a * t.d - t.b * t.c;
+    auto scaleX = std::sqrt(t.a * t.a + t.b * t.b);
+    auto scaleY = std::sqrt(t.c * t.c + t.d * t.d);
+
+    // ## Mirrored transform
+    if (determinant < 0) {
+        scaleY = -scaleY;
+    }
+
+    return Vector2{ scaleX, scaleY };
+}
+
+} // namespace cen
+
+#endif // CENGINE_TRANSFORM_2D_H
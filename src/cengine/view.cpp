@@ -0,0 +1,15 @@
+#include "view.h"
+
+namespace cen {
+
+const uint64_t TextView::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node2D::_tid);
+
+const uint64_t LineView::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node2D::_tid);
+
+const uint64_t CircleView::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node2D::_tid);
+
+const uint64_t RectangleView::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node2D::_tid);
+
+const uint64_t TileMapView::_tid = cen::TypeIdGenerator::getInstance().getNextId(&Node2D::_tid);
+
+} // namespace cen
\ No newline at end of file
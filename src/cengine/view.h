@@ -10,6 +10,12 @@ namespace cen {
 
 class TextView: public cen::Node2D {
     public:
+        static const uint64_t _tid;
+
+        cen::type_id_t TypeId() const override {
+            return TextView::_tid;
+        }
+
         std::string  text;
         int fontSize;
         Color color;
@@ -28,6 +34,12 @@ class TextView: public cen::Node2D {
 
 class LineView: public cen::Node2D {
     public:
+        static const uint64_t _tid;
+
+        cen::type_id_t TypeId() const override {
+            return LineView::_tid;
+        }
+
         float length;
         float alpha;
         Color color;
@@ -41,6 +53,12 @@ class LineView: public cen::Node2D {
 
 class CircleView: public cen::Node2D {
     public:
+        static const uint64_t _tid;
+
+        cen::type_id_t TypeId() const override {
+            return CircleView::_tid;
+        }
+
         float radius;
         float alpha;
         Color color;
@@ -56,6 +74,12 @@ class CircleView: public cen::Node2D {
 
 class RectangleView: public cen::Node2D {
     public:
+        static const uint64_t _tid;
+
+        cen::type_id_t TypeId() const override {
+            return RectangleView::_tid;
+        }
+
         cen::Size size;
         Color color;
         float alpha;
@@ -69,6 +93,12 @@ class RectangleView: public cen::Node2D {
 
 class TileMapView: public cen::Node2D {
     public:
+        static const uint64_t _tid;
+
+        cen::type_id_t TypeId() const override {
+            return TileMapView::_tid;
+        }
+
         TileMap* map;
 
         TileMapView(
@@ -0,0 +1,122 @@
+#ifndef CENGINE_WORKER_POOL_H
+#define CENGINE_WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace cen {
+
+// # Worker pool
+// Threads are started once and wait for tasks. Run calls task on every worker
+// (calling thread is worker 0) and returns when all of them are done, so task
+// can be a lambda on the stack (nothing is allocated per run).
+
+class WorkerPool {
+    private:
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable started;
+        std::condition_variable finished;
+        uint64_t generation = 0;
+        size_t running = 0;
+        bool stopping = false;
+
+        // # Task of current run
+        void* context = nullptr;
+        void (*call)(void*, size_t) = nullptr;
+
+        void Work(size_t worker) {
+            uint64_t seen = 0;
+
+            while (true) {
+                void* context;
+                void (*call)(void*, size_t);
+
+                {
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    this->started.wait(lock, [&]() {
+                        return this->stopping || this->generation != seen;
+                    });
+
+                    if (this->stopping) {
+                        return;
+                    }
+
+                    seen = this->generation;
+                    context = this->context;
+                    call = this->call;
+                }
+
+                call(context, worker);
+
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    if (--this->running == 0) {
+                        this->finished.notify_one();
+                    }
+                }
+            }
+        }
+
+    public:
+        // # Size counts calling thread
+        WorkerPool(size_t size) {
+            for (size_t worker = 1; worker < size; worker++) {
+                this->threads.emplace_back(&WorkerPool::Work, this, worker);
+            }
+        }
+
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->stopping = true;
+            }
+
+            this->started.notify_all();
+
+            for (auto& thread: this->threads) {
+                thread.join();
+            }
+        }
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        size_t Size() const {
+            return this->threads.size() + 1;
+        }
+
+        // # Calls task(worker) for every worker in 0..Size() and waits for all of them
+        template <typename F>
+        void Run(F& task) {
+            if (this->threads.empty()) {
+                task(0);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->context = &task;
+                this->call = [](void* context, size_t worker) {
+                    (*static_cast<F*>(context))(worker);
+                };
+                this->running = this->threads.size();
+                this->generation++;
+            }
+
+            this->started.notify_all();
+
+            task(0);
+
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->finished.wait(lock, [this]() {
+                return this->running == 0;
+            });
+        }
+};
+
+} // namespace cen
+
+#endif // CENGINE_WORKER_POOL_H
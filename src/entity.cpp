@@ -23,22 +23,20 @@ Map::Map(
 }
 
 void Map::Init() {
-    this->AddNode(
-        std::make_unique<cen::TextView>(
-            Vector2{
-                this->scene->screen.width / 2.0f - MeasureText("title", 50.0f) / 2.0f,
-                100.0f
-            },
-            "title",
-            50.0f,
-            WHITE
-        )
+    this->AddNode<cen::TextView>(
+        Vector2{
+            this->scene->screen.width / 2.0f - MeasureText("title", 50.0f) / 2.0f,
+            100.0f
+        },
+        "title",
+        50.0f,
+        WHITE
     );
 
     std::ifstream f(cen::GetResourcePath("map/wild-drift-first.json"));
     json data = json::parse(f);
 
-    cen::TileMap tileMap;
+    auto& tileMap = this->tileMap;
 
     tileMap.path = this->path;
     tileMap.width = data["width"];
@@ -77,6 +75,25 @@ void Map::Init() {
             for (auto& tile : layer["data"]) {
                 tileMapLayer.data.push_back(tile);
             }
+
+            tileMap.layers.push_back(std::move(tileMapLayer));
+        }
+    }
+
+    // # Walls as static tile map body (adjacent tiles merged into colliders,
+    // motion queries look up cells)
+    for (const auto& layer : tileMap.layers) {
+        if (layer.name != Map::wallsLayer) {
+            continue;
         }
+
+        this->AddNode<cen::TileMapCollision2D>(
+            Vector2{},
+            layer,
+            cen::Size{
+                static_cast<float>(tileMap.tileWidth),
+                static_cast<float>(tileMap.tileHeight)
+            }
+        );
     }
 }
\ No newline at end of file
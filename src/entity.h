@@ -10,6 +10,10 @@ class Map: public cen::Node2D {
     std::string name;
     std::string description;
     std::string path;
+    cen::TileMap tileMap;
+
+    // # Tile layers whose tiles are solid (merged into static colliders)
+    static constexpr const char* wallsLayer = "walls";
 
     Map(
         std::string name,
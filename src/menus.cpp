@@ -9,36 +9,32 @@ void MainMenu::Init() {
     auto yStart = this->scene->screen.height / 2.0f - titleFontSize / 2.0f - 30.0f;
     auto btnStart = yStart + 100.0f;
 
-    this->AddNode(
-        std::make_unique<cen::TextView>(
-            Vector2{
-                this->scene->screen.width / 2.0f - MeasureText(title, titleFontSize) / 2.0f,
-                yStart
-            },
-            title,
-            titleFontSize,
-            WHITE
-        )
+    this->AddNode<cen::TextView>(
+        Vector2{
+            this->scene->screen.width / 2.0f - MeasureText(title, titleFontSize) / 2.0f,
+            yStart
+        },
+        title,
+        titleFontSize,
+        WHITE
     );
 
-    this->AddNode(
-        std::make_unique<cen::Btn>(
-            start,
-            btnFontSize,
-            Vector2{
-                this->scene->screen.width / 2.0f,
-                btnStart
-            },
-            cen::Size{ 0, 0 },
-            Vector2{ 0.5, 0.5 },
-            cen::Callbacks(
-                nullptr,
-                nullptr,
-                nullptr,
-                [this](cen::Btn* btn) {
-                    this->scene->eventBus.Emit(std::make_unique<StartEvent>());
-                }
-            )
+    this->AddNode<cen::Btn>(
+        start,
+        btnFontSize,
+        Vector2{
+            this->scene->screen.width / 2.0f,
+            btnStart
+        },
+        cen::Size{ 0, 0 },
+        Vector2{ 0.5, 0.5 },
+        cen::Callbacks(
+            nullptr,
+            nullptr,
+            nullptr,
+            [this](cen::Btn* btn) {
+                this->scene->eventBus.Emit(std::make_unique<StartEvent>());
+            }
         )
     );
 }
\ No newline at end of file
@@ -7,7 +7,7 @@ void MainMenuScene::Init() {
     EnableCursor();
 
     // ## MainMenu
-    MainMenu* mainMenu = this->AddNode(std::make_unique<MainMenu>());
+    MainMenu* mainMenu = this->AddNode<MainMenu>();
 
     this->eventBus.On(
         StartEvent{},
@@ -30,12 +30,10 @@ void MainMenuScene::Init() {
 void LocalMatchScene::Init() {
     DisableCursor();
 
-    this->AddNode(
-        std::make_unique<Map>(
-            "main",
-            "main map",
-            "",
-            Vector2{ 0, 0 }
-        )
+    this->AddNode<Map>(
+        "main",
+        "main map",
+        "",
+        Vector2{ 0, 0 }
     );
 }
\ No newline at end of file
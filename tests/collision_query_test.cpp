@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <memory>
+#include "../src/cengine/collision.h"
+#include "../src/cengine/node_node_storage.h"
+
+// # Motion queries must see bodies where they are now, not where broadphase
+// saw them in last collision check
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* broadphase, const char* message) {
+    if (!condition) {
+        std::printf("FAIL [%s] %s\n", broadphase, message);
+        failures++;
+    }
+}
+
+static cen::CollisionObject2D* AddBody(cen::NodeStorage& nodeStorage, Vector2 position, cen::Shape shape, bool isStatic = false) {
+    auto body = nodeStorage.AddNode<cen::CollisionObject2D>(position);
+    body->isStatic = isStatic;
+    body->AddNode<cen::Collider>(cen::ColliderType::Solid, shape);
+
+    return body;
+}
+
+static size_t CastBall(cen::CollisionEngine& engine, cen::NodeStorage& nodeStorage, cen::CastHit* hits) {
+    return engine.ShapeCast(&nodeStorage, cen::Shape::Circle(5), { 0, 0 }, { 100, 0 }, {}, hits, 2);
+}
+
+static void Run(std::unique_ptr<cen::Broadphase> broadphase, const char* name) {
+    cen::NodeStorage nodeStorage;
+    cen::CollisionEngine engine(std::move(broadphase));
+    cen::CastHit hits[2];
+
+    // # Paddle starts off the ball path
+    auto paddle = AddBody(nodeStorage, { 50, 40 }, cen::Shape::Rectangle({ 4, 40 }));
+    nodeStorage.Init();
+    nodeStorage.UpdateGlobalTransforms();
+    engine.CollisionCheck(&nodeStorage);
+
+    Expect(CastBall(engine, nodeStorage, hits) == 0, name, "paddle off path is hit");
+
+    // # Paddle moves into ball path between checks
+    paddle->SetPosition({ 50, 10 });
+    auto count = CastBall(engine, nodeStorage, hits);
+    Expect(count == 1 && hits[0].collisionObject == paddle, name, "paddle moved into path since check is missed");
+
+    // # Paddle leaves path again
+    paddle->Translate({ 0, 50 });
+    Expect(CastBall(engine, nodeStorage, hits) == 0, name, "paddle moved out of path since check is hit");
+
+    // # Direct write is picked up by UpdateGlobalTransforms
+    paddle->position.y = 0;
+    nodeStorage.UpdateGlobalTransforms();
+    count = CastBall(engine, nodeStorage, hits);
+    Expect(count == 1 && hits[0].collisionObject == paddle, name, "paddle written directly into path is missed");
+
+    paddle->SetPosition({ 50, 60 });
+
+    // # Body spawned after check
+    auto spawned = AddBody(nodeStorage, { 30, 0 }, cen::Shape::Circle(4));
+    count = CastBall(engine, nodeStorage, hits);
+    Expect(count == 1 && hits[0].collisionObject == spawned, name, "body added since check is missed");
+
+    cen::OverlapHit overlaps[2];
+    Expect(
+        engine.OverlapShape(&nodeStorage, cen::Shape::Circle(5), { 30, 0 }, {}, overlaps, 2) == 1,
+        name,
+        "overlap misses body added since check"
+    );
+
+    // # Static wall is found from static grid while unchanged, and where it is after it moved
+    spawned->QueueRemove();
+    nodeStorage.FlushRemovals();
+    auto wall = AddBody(nodeStorage, { 80, 0 }, cen::Shape::Rectangle({ 4, 40 }), true);
+    nodeStorage.UpdateGlobalTransforms();
+    engine.CollisionCheck(&nodeStorage);
+
+    count = CastBall(engine, nodeStorage, hits);
+    Expect(count == 1 && hits[0].collisionObject == wall, name, "static wall is missed");
+
+    wall->SetPosition({ 40, 0 });
+    count = CastBall(engine, nodeStorage, hits);
+    Expect(count == 1 && hits[0].collisionObject == wall && hits[0].hit.time < 0.4f, name, "static wall moved since check is hit where it was");
+}
+
+int main() {
+    Run(std::make_unique<cen::SpatialHashGrid>(), "SpatialHashGrid");
+    Run(std::make_unique<cen::AABBTree>(), "AABBTree");
+    Run(std::make_unique<cen::SweepAndPrune>(), "SweepAndPrune");
+    Run(nullptr, "naive");
+
+    if (failures > 0) {
+        return 1;
+    }
+
+    std::printf("collision query test passed\n");
+    return 0;
+}